@@ -10,26 +10,26 @@
 class ObjectListItem final : public QListWidgetItem
 {
 public:
-    ObjectListItem(const UP_ObjectStructure& obj)
+    ObjectListItem(const SP_ObjectStructure& obj)
         : QListWidgetItem(obj->mName.c_str()),
           mObj(obj)
     {
 
     }
 
-    const UP_ObjectStructure& GetObjectStructure() const
+    const SP_ObjectStructure& GetObjectStructure() const
     {
         return mObj;
     }
 
 private:
-    const UP_ObjectStructure& mObj;
+    const SP_ObjectStructure& mObj;
 };
 
 class AddNewObjectCommand : public QUndoCommand
 {
 public:
-    AddNewObjectCommand(EditorTab* pTab, const UP_ObjectStructure& objStructure)
+    AddNewObjectCommand(EditorTab* pTab, const SP_ObjectStructure& objStructure)
         : mTab(pTab),
         mObjStructure(objStructure),
         mSelectionSaver(pTab)
@@ -50,19 +50,8 @@ public:
 
     void undo() override
     {
-        // Remove from model
-        for (auto it = mCamera->mMapObjects.begin(); it != mCamera->mMapObjects.end(); it++)
-        {
-            if (it->get() == mNewItem->GetMapObject())
-            {
-                // Do not delete
-                it->release();
-
-                mCamera->mMapObjects.erase(it);
-
-                break;
-            }
-        }
+        // Remove from model, do not delete
+        mCamera->TakeMapObject(mNewItem->GetMapObject()).release();
 
         // Remove from scene
         mTab->GetScene().removeItem(mNewItem);
@@ -74,7 +63,7 @@ public:
     void redo() override
     {
         // Add to model
-        mCamera->mMapObjects.emplace_back(std::unique_ptr<MapObject>(mNewItem->GetMapObject()));
+        mCamera->AddMapObject(std::unique_ptr<MapObject>(mNewItem->GetMapObject()));
 
         // Add to scene
         mTab->GetScene().addItem(mNewItem);
@@ -120,19 +109,8 @@ private:
         auto pNewMapObj = new MapObject();
 
         pNewMapObj->mObjectStructureType = mObjStructure->mName;
-        for (auto& prop : mObjStructure->mEnumAndBasicTypeProperties)
-        {
-            auto foundType = mTab->GetModel().FindType(prop.mType);
-
-            auto newProp = mTab->GetModel().MakeProperty(foundType, prop, mObjStructure.get());
-            if (foundType.mEnum)
-            {
-                auto enumType = mTab->GetModel().FindEnum(prop.mType);
-                newProp->mEnumValue = enumType->mValues[0];
-            }
-
-            pNewMapObj->mProperties.emplace_back(std::move(newProp));
-        }
+        pNewMapObj->mStructure = mObjStructure;
+        pNewMapObj->mProperties = mTab->GetModel().DefaultProperties(*mObjStructure);
 
         pNewMapObj->SetXPos(viewPos.x());
         pNewMapObj->SetYPos(viewPos.y());
@@ -147,7 +125,7 @@ private:
     bool mAdded = false;
     ResizeableRectItem* mNewItem = nullptr;
     EditorTab* mTab;
-    const UP_ObjectStructure& mObjStructure;
+    const SP_ObjectStructure& mObjStructure;
 };
 
 AddObjectDialog::AddObjectDialog(QWidget *parent, EditorTab* pTab) :
@@ -189,7 +167,7 @@ void AddObjectDialog::on_buttonBox_accepted()
     if (!ui->lstObjects->selectedItems().isEmpty())
     {
         auto pItem = static_cast<ObjectListItem*>(ui->lstObjects->selectedItems().at(0));
-        const UP_ObjectStructure& objStructure = pItem->GetObjectStructure();
+        const SP_ObjectStructure& objStructure = pItem->GetObjectStructure();
         mTab->AddCommand(new AddNewObjectCommand(mTab, objStructure));
     }
 }
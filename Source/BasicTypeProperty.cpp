@@ -13,15 +13,13 @@ ChangeBasicTypePropertyCommand::ChangeBasicTypePropertyCommand(LinkedProperty li
 void ChangeBasicTypePropertyCommand::undo()
 {
     mLinkedProperty.mProperty->mBasicTypeValue = mPropertyData.mOldValue;
-    mLinkedProperty.mTreeWidget->FindObjectPropertyByKey(mLinkedProperty.mProperty)->Refresh();
-    mLinkedProperty.mGraphicsItem->SyncInternalObject();
+    mLinkedProperty.mGraphicsItem->MarkInternalObjectDirty();
 }
 
 void ChangeBasicTypePropertyCommand::redo()
 {
     mLinkedProperty.mProperty->mBasicTypeValue = mPropertyData.mNewValue;
-    mLinkedProperty.mTreeWidget->FindObjectPropertyByKey(mLinkedProperty.mProperty)->Refresh();
-    mLinkedProperty.mGraphicsItem->SyncInternalObject();
+    mLinkedProperty.mGraphicsItem->MarkInternalObjectDirty();
 }
 
 bool ChangeBasicTypePropertyCommand::mergeWith(const QUndoCommand* command)
@@ -46,10 +44,10 @@ bool ChangeBasicTypePropertyCommand::mergeWith(const QUndoCommand* command)
 
 void ChangeBasicTypePropertyCommand::UpdateText()
 {
-    setText(QString("Change property %1 from %2 to %3").arg(mLinkedProperty.mProperty->mName.c_str(), QString::number(mPropertyData.mOldValue), QString::number(mPropertyData.mNewValue)));
+    setText(QString("Change property %1 from %2 to %3").arg(mLinkedProperty.mProperty->Name().c_str(), QString::number(mPropertyData.mOldValue), QString::number(mPropertyData.mNewValue)));
 }
 
-BasicTypeProperty::BasicTypeProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem, BasicType* pBasicType) : PropertyTreeItemBase(pParent, QStringList{ propertyName, QString::number(pProperty->mBasicTypeValue) }), mUndoStack(undoStack), mProperty(pProperty), mBasicType(pBasicType), mGraphicsItem(pGraphicsItem)
+BasicTypeProperty::BasicTypeProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem, const BasicType* pBasicType) : PropertyTreeItemBase(pParent, QStringList{ propertyName, QString::number(pProperty->mBasicTypeValue) }), mUndoStack(undoStack), mProperty(pProperty), mBasicType(pBasicType), mGraphicsItem(pGraphicsItem)
 {
 
 }
@@ -68,7 +66,7 @@ QWidget* BasicTypeProperty::CreateEditorWidget(PropertyTreeWidget* pParent)
             if (mOldValue != newValue)
             {
                 mUndoStack.push(new ChangeBasicTypePropertyCommand(
-                    LinkedProperty(pParent, this->mProperty, this->mGraphicsItem),
+                    LinkedProperty(this->mProperty, this->mGraphicsItem),
                     BasicTypePropertyChangeData(this->mBasicType, this->mOldValue, newValue)));
             }
             mOldValue = newValue;
@@ -9,12 +9,12 @@ class BigSpinBox;
 
 struct BasicTypePropertyChangeData
 {
-    BasicTypePropertyChangeData(BasicType* pBasicType, int oldValue, int newValue)
+    BasicTypePropertyChangeData(const BasicType* pBasicType, int oldValue, int newValue)
         : mBasicType(pBasicType), mOldValue(oldValue), mNewValue(newValue)
     {
 
     }
-    BasicType* mBasicType = nullptr;
+    const BasicType* mBasicType = nullptr;
     int mOldValue = 0;
     int mNewValue = 0;
 };
@@ -46,22 +46,17 @@ class BasicTypeProperty final : public QObject, public PropertyTreeItemBase
 {
     Q_OBJECT
 public:
-    BasicTypeProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem, BasicType* pBasicType);
+    BasicTypeProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem, const BasicType* pBasicType);
 
     QWidget* CreateEditorWidget(PropertyTreeWidget* pParent) override;
 
-    const void* GetPropertyLookUpKey() const override
-    {
-        return mProperty;
-    }
-
     void Refresh() override;
 
 private:
     QUndoStack& mUndoStack;
     ObjectProperty* mProperty = nullptr;
     IGraphicsItem* mGraphicsItem = nullptr;
-    BasicType* mBasicType = nullptr;
+    const BasicType* mBasicType = nullptr;
     int mOldValue = 0;
     BigSpinBox* mSpinBox = nullptr;
 };
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Model.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Reading and writing of the binary caches and clipboard data. Values are written in native byte order as the data is
+// only ever read back on the machine that wrote it.
+
+class BinaryWriter final
+{
+public:
+    template<typename T>
+    void Write(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        mData.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void WriteString(std::string_view str)
+    {
+        Write(static_cast<uint32_t>(str.size()));
+        mData.append(str);
+    }
+
+    std::string& Data()
+    {
+        return mData;
+    }
+
+private:
+    std::string mData;
+};
+
+class BinaryReader final
+{
+public:
+    BinaryReader(const char* pData, size_t size)
+        : mData(pData), mSize(size)
+    {
+
+    }
+
+    template<typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string ReadString()
+    {
+        const uint32_t len = Read<uint32_t>();
+        return std::string(Take(len), len);
+    }
+
+    // Returns a pointer to the next len bytes and skips over them
+    const char* ReadBytes(size_t len)
+    {
+        return Take(len);
+    }
+
+    size_t Position() const
+    {
+        return mPos;
+    }
+
+    bool AtEnd() const
+    {
+        return mPos == mSize;
+    }
+
+private:
+    const char* Take(size_t len)
+    {
+        if (len > mSize - mPos)
+        {
+            throw InvalidBinaryException();
+        }
+        const char* p = mData + mPos;
+        mPos += len;
+        return p;
+    }
+
+    const char* mData = nullptr;
+    size_t mSize = 0;
+    size_t mPos = 0;
+};
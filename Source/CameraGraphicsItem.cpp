@@ -54,9 +54,9 @@ void CameraGraphicsItem::LoadImages()
 {
     if (mCamera)
     {
-        if (!mCamera->mCameraImageandLayers.mCameraImage.empty())
+        if (!mCamera->mCameraImageandLayers->mCameraImage.empty())
         {
-            mImages.mCamera.loadFromData(QByteArray::fromBase64(QByteArray(mCamera->mCameraImageandLayers.mCameraImage.c_str(), static_cast<int>(mCamera->mCameraImageandLayers.mCameraImage.length()))));
+            mImages.mCamera.loadFromData(QByteArray::fromBase64(QByteArray(mCamera->mCameraImageandLayers->mCameraImage.c_str(), static_cast<int>(mCamera->mCameraImageandLayers->mCameraImage.length()))));
         }
     }
 }
\ No newline at end of file
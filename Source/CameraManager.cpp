@@ -83,38 +83,27 @@ public:
     
     void redo() override
     {
+        ModelChangeBatch batch(mTab->GetModel());
+
         mItem->GetCamera()->mId = mNewCamId;
         mItem->GetCamera()->mName = mNewCamName;
+        mItem->GetCamera()->MarkChanged();
 
         mItem->SetImage(mCamImage);
-        mItem->GetCamera()->mCameraImageandLayers.mCameraImage = PixmapToBase64PngString(mCamImage);
-
-        mTab->GetScene().update();
-
-        // Update camera manager UI if open
-        CameraManager* pMgr = mTab->GetCameraManagerDialog();
-        if (pMgr)
-        {
-            pMgr->OnCameraIdChanged(mItem->GetCamera());
-        }
+        const std::string image = PixmapToBase64PngString(mCamImage);
+        mItem->GetCamera()->ChangeImages([&](Camera::CameraImageAndLayers& images) { images.mCameraImage = image; });
     }
 
     void undo() override
     {
+        ModelChangeBatch batch(mTab->GetModel());
+
         mItem->GetCamera()->mId = 0;
         mItem->GetCamera()->mName.clear();
+        mItem->GetCamera()->MarkChanged();
 
         mItem->SetImage(QPixmap());
-        mItem->GetCamera()->mCameraImageandLayers.mCameraImage.clear();
-
-        mTab->GetScene().update();
-
-        // Update camera manager UI if open
-        CameraManager* pMgr = mTab->GetCameraManagerDialog();
-        if (pMgr)
-        {
-            pMgr->OnCameraIdChanged(mItem->GetCamera());
-        }
+        mItem->GetCamera()->ChangeImages([](Camera::CameraImageAndLayers& images) { images.mCameraImage.clear(); });
     }
 
 private:
@@ -128,8 +117,8 @@ private:
 class ChangeCameraImageCommand final : public QUndoCommand
 {
 public:
-    ChangeCameraImageCommand(CameraGraphicsItem* pCameraGraphicsItem, QPixmap newImage, TabImageIdx imgIdx, EditorTab* pEditorTab)
-        : mCameraGraphicsItem(pCameraGraphicsItem), mEditorTab(pEditorTab),  mNewImage(newImage), mImgIdx(imgIdx)
+    ChangeCameraImageCommand(CameraGraphicsItem* pCameraGraphicsItem, QPixmap newImage, TabImageIdx imgIdx)
+        : mCameraGraphicsItem(pCameraGraphicsItem), mNewImage(newImage), mImgIdx(imgIdx)
     {
         // todo: set correctly
         QString posStr = QString::number(mCameraGraphicsItem->GetCamera()->mX) + "," + QString::number(mCameraGraphicsItem->GetCamera()->mY);
@@ -143,22 +132,22 @@ public:
             break;
 
         case Foreground:
-            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mForegroundLayer);
+            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers->mForegroundLayer);
             setText("Change camera foreground image at " + posStr);
             break;
 
         case Background:
-            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mBackgroundLayer);
+            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers->mBackgroundLayer);
             setText("Change camera background image at " + posStr);
             break;
 
         case ForegroundWell:
-            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mForegroundWellLayer);
+            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers->mForegroundWellLayer);
             setText("Change camera foreground well image at " + posStr);
             break;
 
         case BackgroundWell:
-            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mBackgroundWellLayer);
+            mOldImage = Base64ToPixmap(mCameraGraphicsItem->GetCamera()->mCameraImageandLayers->mBackgroundWellLayer);
             setText("Change camera background well image at " + posStr);
             break;
         }
@@ -177,34 +166,40 @@ public:
 private:
     void UpdateImage(QPixmap img)
     {
-        switch (mImgIdx)
+        if (mImgIdx == Main)
         {
-        case Main:
             mCameraGraphicsItem->SetImage(img);
-            mEditorTab->GetScene().invalidate();
-            mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mCameraImage = PixmapToBase64PngString(img);
-            break;
+        }
 
-        case Foreground:
-            mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mForegroundLayer = PixmapToBase64PngString(img);
-            break;
+        const std::string image = PixmapToBase64PngString(img);
+        mCameraGraphicsItem->GetCamera()->ChangeImages([&](Camera::CameraImageAndLayers& images)
+            {
+                switch (mImgIdx)
+                {
+                case Main:
+                    images.mCameraImage = image;
+                    break;
 
-        case Background:
-            mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mBackgroundLayer = PixmapToBase64PngString(img);
-            break;
+                case Foreground:
+                    images.mForegroundLayer = image;
+                    break;
 
-        case ForegroundWell:
-            mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mForegroundWellLayer = PixmapToBase64PngString(img);
-            break;
+                case Background:
+                    images.mBackgroundLayer = image;
+                    break;
 
-        case BackgroundWell:
-            mCameraGraphicsItem->GetCamera()->mCameraImageandLayers.mBackgroundWellLayer = PixmapToBase64PngString(img);
-            break;
-        };
+                case ForegroundWell:
+                    images.mForegroundWellLayer = image;
+                    break;
+
+                case BackgroundWell:
+                    images.mBackgroundWellLayer = image;
+                    break;
+                };
+            });
     }
 
     CameraGraphicsItem* mCameraGraphicsItem = nullptr;
-    EditorTab* mEditorTab;
 
     QPixmap mNewImage;
     QPixmap mOldImage;
@@ -254,12 +249,14 @@ public:
 
     void undo() override
     {
+        EditTransaction transaction(mTab, mGraphicsItemMapObjects.count() + 1);
+
         // Remove "blank" graphics item
         mTab->GetScene().removeItem(mEmptyCamera);
         mEmptyCameraModel = mTab->GetModel().RemoveCamera(mEmptyCamera->GetCamera());
 
         // Move empty camera map objects to original camera
-        mCameraOriginalModel->mMapObjects = std::move(mEmptyCameraModel->mMapObjects);
+        mCameraOriginalModel->TakeMapObjectsFrom(*mEmptyCameraModel);
 
         // Add back the original camera
         mTab->GetModel().AddCamera(std::move(mCameraOriginalModel));
@@ -284,12 +281,14 @@ public:
 
     void redo() override
     {
+        EditTransaction transaction(mTab, mGraphicsItemMapObjects.count() + 1);
+
         // Remove original camera
         mCameraOriginalModel = mTab->GetModel().RemoveCamera(mCameraOriginal->GetCamera());
         mTab->GetScene().removeItem(mCameraOriginal);
 
         // Move original map objects to blank camera
-        mEmptyCameraModel->mMapObjects = std::move(mCameraOriginalModel->mMapObjects);
+        mEmptyCameraModel->TakeMapObjectsFrom(*mCameraOriginalModel);
 
         // Remove map object graphics items
         for (auto& item : mGraphicsItemMapObjects)
@@ -463,7 +462,7 @@ void CameraManager::CreateCamera(bool dropEvent, QPixmap img)
     {
         // Update image of existing camera
         auto index = dropEvent ? TabImageIdx::Main : static_cast<TabImageIdx>(ui->tabWidget->currentIndex());
-        mTab->AddCommand(new ChangeCameraImageCommand(pCameraGraphicsItem, img, index, mTab));
+        mTab->AddCommand(new ChangeCameraImageCommand(pCameraGraphicsItem, img, index));
         UpdateTabImages(pCameraGraphicsItem);
     }
     else
@@ -586,7 +585,7 @@ void CameraManager::on_btnDeleteImage_clicked()
             // Don't allow removing of the main camera image, because that makes no sense
             if (ui->tabWidget->currentIndex() != 0)
             {
-                mTab->AddCommand(new ChangeCameraImageCommand(pCameraGraphicsItem, QPixmap(), static_cast<TabImageIdx>(ui->tabWidget->currentIndex()), mTab));
+                mTab->AddCommand(new ChangeCameraImageCommand(pCameraGraphicsItem, QPixmap(), static_cast<TabImageIdx>(ui->tabWidget->currentIndex())));
                 UpdateTabImages(pCameraGraphicsItem);
             }
             else
@@ -616,15 +615,7 @@ public:
         int pathIdShifted = mTab->GetModel().GetMapInfo().mPathId * 100;
         const int id = mNewId - pathIdShifted;
         mItem->GetCamera()->mName = CameraNameFromId(mTab->GetModel(), id);
-        
-        mTab->GetScene().update();
-
-        // Update camera manager UI if open
-        CameraManager* pMgr = mTab->GetCameraManagerDialog();
-        if (pMgr)
-        {
-            pMgr->OnCameraIdChanged(mItem->GetCamera());
-        }
+        mItem->GetCamera()->MarkChanged();
     }
 
     void undo() override
@@ -633,15 +624,7 @@ public:
         int pathIdShifted = mTab->GetModel().GetMapInfo().mPathId * 100;
         const int id = mOldId - pathIdShifted;
         mItem->GetCamera()->mName = CameraNameFromId(mTab->GetModel(), id);
-
-        mTab->GetScene().update();
-
-        // Update camera manager UI if open
-        CameraManager* pMgr = mTab->GetCameraManagerDialog();
-        if (pMgr)
-        {
-            pMgr->OnCameraIdChanged(mItem->GetCamera());
-        }
+        mItem->GetCamera()->MarkChanged();
     }
 
 private:
@@ -714,10 +697,10 @@ void CameraManager::SetTabImage(int idx, QPixmap img)
 void CameraManager::UpdateTabImages(CameraGraphicsItem* pItem)
 {
     SetTabImage(TabImageIdx::Main, pItem->GetImage());
-    SetTabImage(TabImageIdx::Foreground, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers.mForegroundLayer));
-    SetTabImage(TabImageIdx::Background, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers.mBackgroundLayer));
-    SetTabImage(TabImageIdx::ForegroundWell, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers.mForegroundWellLayer));
-    SetTabImage(TabImageIdx::BackgroundWell, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers.mBackgroundWellLayer));
+    SetTabImage(TabImageIdx::Foreground, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers->mForegroundLayer));
+    SetTabImage(TabImageIdx::Background, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers->mBackgroundLayer));
+    SetTabImage(TabImageIdx::ForegroundWell, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers->mForegroundWellLayer));
+    SetTabImage(TabImageIdx::BackgroundWell, Base64ToPixmap(pItem->GetCamera()->mCameraImageandLayers->mBackgroundWellLayer));
 }
 
 void CameraManager::on_btnDeleteCamera_clicked()
@@ -307,12 +307,14 @@ public:
             QString::number(mNewXSize) + "x" + QString::number(mNewYSize));
 
         auto edits = CalcMapChanges(mOldXSize, mNewXSize, mOldYSize, mNewYSize);
+        const auto cameraItems = mTab->GetScene().CameraItemsByPosition();
 
         for (auto& edit : edits)
         {
             if (!edit.mAdd)
             {
-                CameraGraphicsItem* pCam = mTab->GetScene().CameraAt(edit.x, edit.y);
+                auto it = cameraItems.find(std::make_pair(edit.x, edit.y));
+                CameraGraphicsItem* pCam = it != cameraItems.end() ? it->second : nullptr;
                 mRemovedCameras.emplace_back(std::make_unique<RemovedCamera>(pCam, &mTab->GetScene()));
             }
             else
@@ -320,10 +322,18 @@ public:
                 mAddedCameras.emplace_back(std::make_unique<AddedCamera>(mTab, edit.x, edit.y));
             }
         }
+
+        mItemCount = static_cast<int>(mRemovedCameras.size() + mAddedCameras.size());
+        for (const auto& removed : mRemovedCameras)
+        {
+            mItemCount += removed->mGraphicsItemMapObjects.count();
+        }
     }
 
     void undo() override
     {
+        EditTransaction transaction(mTab, mItemCount);
+
         mTab->GetModel().GetMapInfo().mXSize = mOldXSize;
         mTab->GetModel().GetMapInfo().mYSize = mOldYSize;
 
@@ -347,6 +357,8 @@ public:
 
     void redo() override
     {
+        EditTransaction transaction(mTab, mItemCount);
+
         mSelectionSaver.redo();
 
         mTab->GetModel().GetMapInfo().mXSize = mNewXSize;
@@ -381,6 +393,9 @@ private:
 
     std::vector<std::unique_ptr<RemovedCamera>> mRemovedCameras;
     std::vector<std::unique_ptr<AddedCamera>> mAddedCameras;
+
+    // Cameras and objects added or removed, for the transaction
+    int mItemCount = 0;
 };
 
 ChangeMapSizeDialog::ChangeMapSizeDialog(QWidget *parent, EditorTab* pTab) :
@@ -2,21 +2,32 @@
 #include "EditorTab.hpp"
 #include "ResizeableArrowItem.hpp"
 #include "ResizeableRectItem.hpp"
-
-PasteItemsCommand::PasteItemsCommand(EditorTab* pTab, ClipBoard& clipBoard)
+#include "BinaryStream.hpp"
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QMimeData>
+#include <algorithm>
+#include <limits>
+
+PasteItemsCommand::PasteItemsCommand(EditorTab* pTab, ClipBoard& clipBoard, const QPoint* pos)
     : mTab(pTab), mSelectionSaver(pTab)
 {
-    // Make another deep copy of the items and create graphics items for them
-    mCollisions = clipBoard.CloneCollisions(nullptr);
+    // Make the items from the clipboard data and create graphics items for them
+    ClipBoard::Items items = clipBoard.Decode(mTab->GetModel(), pos);
+    mCollisions = std::move(items.mCollisions);
+    mCollisionGraphicsObjects.reserve(mCollisions.size());
+
+    // Fix collision line ids, all taken at once as a block
+    int nextId = mTab->GetModel().ReserveCollisionIds(static_cast<int>(mCollisions.size()));
     for (auto& obj : mCollisions)
     {
-        // Fix collision line ids
-        obj->mId = mTab->GetModel().NextCollisionId();
+        obj->mId = nextId++;
         mCollisionGraphicsObjects.emplace_back(mTab->MakeResizeableArrowItem(obj.get()));
     }
 
-    auto clonedMapObjects = clipBoard.CloneMapObjects(nullptr);
-    for (auto& obj : clonedMapObjects)
+    mMapObjects.reserve(items.mMapObjects.size());
+    mMapGraphicsObjects.reserve(items.mMapObjects.size());
+    for (auto& obj : items.mMapObjects)
     {
         // Create the graphics item
         ResizeableRectItem* mapObjectGraphicsItem = mTab->MakeResizeableRectItem(obj.get());
@@ -55,45 +66,40 @@ PasteItemsCommand::~PasteItemsCommand()
 
 void PasteItemsCommand::redo()
 {
+    EditTransaction transaction(mTab, static_cast<int>(mMapGraphicsObjects.size() + mCollisionGraphicsObjects.size()));
+
+    // Select only what is pasted. Items are selected before they are added so the scene takes the selection
+    // along with each item rather than updating it again for every one.
+    mTab->GetScene().clearSelection();
+
     // Add to scene
     for (auto& obj : mMapGraphicsObjects)
     {
+        obj->setSelected(true);
         mTab->GetScene().addItem(obj);
     }
 
     // Add to model
     for (auto& obj : mMapObjects)
     {
-        obj.mContainingCamera->mMapObjects.emplace_back(std::move(obj.mPastedMapObject));
+        obj.mContainingCamera->AddMapObject(std::move(obj.mPastedMapObject));
     }
     mMapObjects.clear();
 
     // Add to scene
     for (auto& obj : mCollisionGraphicsObjects)
     {
+        obj->setSelected(true);
         mTab->GetScene().addItem(obj);
     }
 
     // Add to model
     for (auto& obj : mCollisions)
     {
-        mTab->GetModel().CollisionItems().emplace_back(std::move(obj));
+        mTab->GetModel().AddCollisionItem(std::move(obj));
     }
     mCollisions.clear();
 
-    mTab->GetScene().clearSelection();
-
-    // Select what was pasted
-    for (auto& obj : mMapGraphicsObjects)
-    {
-        obj->setSelected(true);
-    }
-
-    for (auto& obj : mCollisionGraphicsObjects)
-    {
-        obj->setSelected(true);
-    }
-
     mPasted = true;
 
     mSelectionSaver.redo();
@@ -101,6 +107,8 @@ void PasteItemsCommand::redo()
 
 void PasteItemsCommand::undo()
 {
+    EditTransaction transaction(mTab, static_cast<int>(mMapGraphicsObjects.size() + mCollisionGraphicsObjects.size()));
+
     for (auto& obj : mMapGraphicsObjects)
     {
         // Remove from model
@@ -114,20 +122,27 @@ void PasteItemsCommand::undo()
         mTab->GetScene().removeItem(obj);
     }
 
+    std::vector<CollisionObject*> collisionsToRemove;
     for (auto& obj : mCollisionGraphicsObjects)
     {
-        // Remove from model
-        mCollisions.emplace_back(mTab->GetModel().RemoveCollisionItem(obj->GetCollisionItem()));
+        collisionsToRemove.push_back(obj->GetCollisionItem());
 
         // Remove from scene
         mTab->GetScene().removeItem(obj);
     }
 
+    // Remove from model
+    mCollisions = mTab->GetModel().RemoveCollisionItems(collisionsToRemove);
+
     mPasted = false;
 
     mSelectionSaver.undo();
 }
 
+// Native byte order like the caches, the clipboard is only shared by editors on the same machine
+static const char kMimeType[] = "application/x-relive-editor-items";
+static constexpr uint32_t kFormatVersion = 1;
+
 void ClipBoard::Set(const QList<QGraphicsItem*>& items, Model& model)
 {
     if (items.isEmpty())
@@ -135,34 +150,119 @@ void ClipBoard::Set(const QList<QGraphicsItem*>& items, Model& model)
         return;
     }
 
-    mSourceGame = model.GetMapInfo().mGame;
+    std::vector<const MapObject*> mapObjects;
+    std::vector<const CollisionObject*> collisions;
 
-    mMapObjects.clear();
-    mCollisions.clear();
+    int left = std::numeric_limits<int>::max();
+    int top = std::numeric_limits<int>::max();
 
-    // Deep copy the items for pasting
     for (int i = 0; i < items.count(); i++)
     {
         QGraphicsItem* obj = items.at(i);
         auto pResizeableRectItem = qgraphicsitem_cast<ResizeableRectItem*>(obj);
         if (pResizeableRectItem)
         {
-            mMapObjects.emplace_back(std::make_unique<MapObject>(*pResizeableRectItem->GetMapObject()));
+            const MapObject& mapObject = *pResizeableRectItem->GetMapObject();
+            mapObjects.emplace_back(&mapObject);
+            left = std::min(left, mapObject.XPos());
+            top = std::min(top, mapObject.YPos());
         }
         else
         {
             auto pResizeableArrowItem = qgraphicsitem_cast<ResizeableArrowItem*>(obj);
             if (pResizeableArrowItem)
             {
-               mCollisions.emplace_back(std::make_unique<CollisionObject>(0, *pResizeableArrowItem->GetCollisionItem()));
+               const CollisionObject& collision = *pResizeableArrowItem->GetCollisionItem();
+               collisions.emplace_back(&collision);
+               left = std::min({ left, collision.X1(), collision.X2() });
+               top = std::min({ top, collision.Y1(), collision.Y2() });
             }
         }
     }
+
+    if (mapObjects.empty() && collisions.empty())
+    {
+        return;
+    }
+
+    BinaryWriter writer;
+    writer.Write(kFormatVersion);
+    writer.WriteString(model.GetMapInfo().mGame);
+    writer.Write(model.GetSchema()->Hash());
+    writer.Write(static_cast<int32_t>(left));
+    writer.Write(static_cast<int32_t>(top));
+
+    writer.Write(static_cast<uint32_t>(mapObjects.size()));
+    writer.Write(static_cast<uint32_t>(collisions.size()));
+    for (const MapObject* pMapObject : mapObjects)
+    {
+        model.SaveBinaryMapObject(writer, *pMapObject);
+    }
+
+    for (const CollisionObject* pCollision : collisions)
+    {
+        model.SaveBinaryCollision(writer, *pCollision);
+    }
+
+    const std::string& data = writer.Data();
+    auto pMimeData = new QMimeData();
+    pMimeData->setData(kMimeType, QByteArray(data.data(), static_cast<int>(data.size())));
+
+    // The clipboard owns the mime data
+    QGuiApplication::clipboard()->setMimeData(pMimeData);
+}
+
+bool ClipBoard::Fetch()
+{
+    Clear();
+
+    const QMimeData* pMimeData = QGuiApplication::clipboard()->mimeData();
+    if (!pMimeData || !pMimeData->hasFormat(kMimeType))
+    {
+        return false;
+    }
+
+    mData = pMimeData->data(kMimeType);
+    try
+    {
+        BinaryReader reader(mData.constData(), static_cast<size_t>(mData.size()));
+        if (reader.Read<uint32_t>() != kFormatVersion)
+        {
+            Clear();
+            return false;
+        }
+
+        mSourceGame = reader.ReadString();
+        mSchemaHash = reader.Read<uint64_t>();
+        const int left = reader.Read<int32_t>();
+        const int top = reader.Read<int32_t>();
+        mTopLeft = QPoint(left, top);
+        mMapObjectCount = reader.Read<uint32_t>();
+        mCollisionCount = reader.Read<uint32_t>();
+        mItemsPosition = reader.Position();
+    }
+    catch (const InvalidBinaryException&)
+    {
+        Clear();
+        return false;
+    }
+    return !IsEmpty();
+}
+
+void ClipBoard::Clear()
+{
+    mData.clear();
+    mItemsPosition = 0;
+    mSourceGame.clear();
+    mSchemaHash = 0;
+    mTopLeft = QPoint();
+    mMapObjectCount = 0;
+    mCollisionCount = 0;
 }
 
 bool ClipBoard::IsEmpty() const
 {
-    return mMapObjects.empty() && mCollisions.empty();
+    return mMapObjectCount == 0 && mCollisionCount == 0;
 }
 
 const std::string& ClipBoard::SourceGame() const
@@ -170,35 +270,57 @@ const std::string& ClipBoard::SourceGame() const
     return mSourceGame;
 }
 
+uint64_t ClipBoard::SchemaHash() const
+{
+    return mSchemaHash;
+}
 
-std::vector<UP_MapObject> ClipBoard::CloneMapObjects(QPoint* pos) const
+QPoint ClipBoard::PasteOffset(const QPoint* pos) const
 {
-    QPoint offset(50, 50);
     if (pos)
     {
-        offset = *pos;
+        return *pos - mTopLeft;
     }
+    return QPoint(50, 50);
+}
 
-    // TODO: Position set or offsetting via pos
-    std::vector<UP_MapObject> r;
-    for (auto& obj : mMapObjects)
+ClipBoard::Items ClipBoard::Decode(Model& model, const QPoint* pos) const
+{
+    const QPoint offset = PasteOffset(pos);
+
+    const size_t itemsSize = static_cast<size_t>(mData.size()) - mItemsPosition;
+    BinaryReader reader(mData.constData() + mItemsPosition, itemsSize);
+
+    // The counts come from another process so check they fit in the data before reserving space for them. A map
+    // object is at least its name, structure name and property count, a line its id and property count.
+    const uint64_t minimumSize = uint64_t{ mMapObjectCount } * 12 + uint64_t{ mCollisionCount } * 8;
+    if (minimumSize > itemsSize)
     {
-        auto copy = std::make_unique<MapObject>(*obj);
-        copy->SetXPos(copy->XPos() + offset.x());
-        copy->SetYPos(copy->YPos() + offset.y());
-        r.emplace_back(std::move(copy));
+        throw InvalidBinaryException();
     }
-    return r;
-}
 
-std::vector<UP_CollisionObject> ClipBoard::CloneCollisions(QPoint* pos) const
-{
-    // TODO: Position set or offsetting via pos
+    Items items;
+    items.mMapObjects.reserve(mMapObjectCount);
+    for (uint32_t i = 0; i < mMapObjectCount; i++)
+    {
+        UP_MapObject pMapObject = model.LoadBinaryMapObject(reader);
+        pMapObject->SetXPos(pMapObject->XPos() + offset.x());
+        pMapObject->SetYPos(pMapObject->YPos() + offset.y());
+        items.mMapObjects.emplace_back(std::move(pMapObject));
+    }
 
-    std::vector<UP_CollisionObject> r;
-    for (auto& obj : mCollisions)
+    items.mCollisions.reserve(mCollisionCount);
+    for (uint32_t i = 0; i < mCollisionCount; i++)
+    {
+        UP_CollisionObject pCollision = model.LoadBinaryCollision(reader);
+        pCollision->mId = 0;
+        pCollision->SetLine(pCollision->X1() + offset.x(), pCollision->Y1() + offset.y(), pCollision->X2() + offset.x(), pCollision->Y2() + offset.y());
+        items.mCollisions.emplace_back(std::move(pCollision));
+    }
+
+    if (!reader.AtEnd())
     {
-        r.emplace_back(std::make_unique<CollisionObject>(0, *obj));
+        throw InvalidBinaryException();
     }
-    return r;
+    return items;
 }
@@ -3,6 +3,8 @@
 #include <QList>
 #include <QGraphicsItem>
 #include <QUndoCommand>
+#include <QPoint>
+#include <QByteArray>
 #include <string>
 #include "Model.hpp"
 #include "SelectionSaver.hpp"
@@ -17,7 +19,8 @@ class ResizeableArrowItem;
 class PasteItemsCommand final : public QUndoCommand
 {
 public:
-    PasteItemsCommand(EditorTab* pTab, ClipBoard& clipBoard);
+    // Pastes at pos if given, see ClipBoard::Decode() and ClipBoard::PasteOffset()
+    PasteItemsCommand(EditorTab* pTab, ClipBoard& clipBoard, const QPoint* pos);
     ~PasteItemsCommand();
     void redo() override;
     void undo() override;
@@ -40,19 +43,48 @@ private:
     bool mPasted = false;
 };
 
+// Copied items are kept on the system clipboard in a compact binary form so they can be pasted into any editor
+// instance. Only the property values are written, pasting reads them back with the schema of the path they're pasted
+// into, which must be the same one they were copied with.
 class ClipBoard final
 {
 public:
+    // The items that are pasted, made in the arena of the model they're pasted into
+    struct Items final
+    {
+        std::vector<UP_MapObject> mMapObjects;
+        std::vector<UP_CollisionObject> mCollisions;
+    };
+
+    // Puts the items on the system clipboard
     void Set(const QList<QGraphicsItem*>& items, Model& model);
+
+    // Reads the header of what is on the system clipboard, false if it holds no items copied by the editor
+    bool Fetch();
+
     bool IsEmpty() const;
 
     const std::string& SourceGame() const;
+    uint64_t SchemaHash() const;
 
-    std::vector<UP_MapObject> CloneMapObjects(QPoint* pos) const;
-    std::vector<UP_CollisionObject> CloneCollisions(QPoint* pos) const;
+    // Items that keep their places relative to each other with the top left of all of them at pos, or just below
+    // and to the right of where they were copied from without one. Lines get id 0, the model gives them theirs.
+    // Throws InvalidBinaryException if the data doesn't fit the model's schema.
+    Items Decode(Model& model, const QPoint* pos) const;
 private:
+    QPoint PasteOffset(const QPoint* pos) const;
+    void Clear();
+
+    // All of the clipboard data, the items start at mItemsPosition
+    QByteArray mData;
+    size_t mItemsPosition = 0;
+
     std::string mSourceGame;
+    uint64_t mSchemaHash = 0;
 
-    std::vector<UP_CollisionObject> mCollisions;
-    std::vector<UP_MapObject> mMapObjects;
+    // Top left of everything in the clipboard
+    QPoint mTopLeft;
+
+    uint32_t mMapObjectCount = 0;
+    uint32_t mCollisionCount = 0;
 };
@@ -1,5 +1,7 @@
 #include "CollisionConnect.hpp"
 
+#include <algorithm>
+#include <unordered_map>
 #include <utility>
 
 CollisionConnectCommand::CollisionConnectCommand(std::vector<CollisionConnectData> collisionConnectData):
@@ -13,6 +15,7 @@ void CollisionConnectCommand::undo()
     for (auto& joinDatum : mCollisionConnectData)
     {
         joinDatum.mObjectProperty->mBasicTypeValue = joinDatum.mOldValue;
+        joinDatum.mCollision->MarkDirty(ModelChange::CollisionRelinked);
     }
 }
 
@@ -21,59 +24,51 @@ void CollisionConnectCommand::redo()
     for (auto& joinDatum : mCollisionConnectData)
     {
         joinDatum.mObjectProperty->mBasicTypeValue = joinDatum.mNewValue;
+        joinDatum.mCollision->MarkDirty(ModelChange::CollisionRelinked);
     }
 }
 
-std::vector<CollisionConnectData> CollisionConnectCommand::getConnectCollisionsChanges(const std::vector<ResizeableArrowItem*> &collisions)
+std::vector<CollisionConnectData> CollisionConnectCommand::getConnectCollisionsChanges(const Model& model, const std::vector<ResizeableArrowItem*> &collisions)
 {
     std::vector<CollisionConnectData> collisionConnectData;
 
-    for (int i = 0; i < collisions.size(); i++)
+    // Where each selected line is in the selection, so lines starting at the same point are linked in the same order
+    // no matter which order the index finds them in
+    std::unordered_map<const CollisionObject*, size_t> selectedIndices;
+    for (size_t i = 0; i < collisions.size(); i++)
     {
-        auto& collision = collisions[i];
-        auto collisionItem = collision->GetCollisionItem();
-        int id = collisionItem->mId;
-
-        int startX = collisionItem->X1();
-        int startY = collisionItem->Y1();
+        selectedIndices.emplace(collisions[i]->GetCollisionItem(), i);
+    }
 
+    std::vector<std::pair<size_t, CollisionObject*>> nextCollisions;
+    for (auto& collision : collisions)
+    {
+        auto collisionItem = collision->GetCollisionItem();
         int endX = collisionItem->X2();
         int endY = collisionItem->Y2();
 
-
-        for (int j = i + 1; j < collisions.size(); j++)
+        // Only the lines near the end of this one, rather than every other selected line
+        nextCollisions.clear();
+        for (CollisionObject* otherCollisionItem : model.GetSpatialIndex().CollisionsIn(SpatialRect{ endX, endY, 0, 0 }))
         {
-            auto& otherCollision = collisions[j];
-            auto otherCollisionItem = otherCollision->GetCollisionItem();
-            int otherId = otherCollisionItem->mId;
-
-            int otherStartX = otherCollisionItem->X1();
-            int otherStartY = otherCollisionItem->Y1();
-
-            int otherEndX = otherCollisionItem->X2();
-            int otherEndY = otherCollisionItem->Y2();
-
-            if (endX == otherStartX && endY == otherStartY)
+            auto selected = selectedIndices.find(otherCollisionItem);
+            if (otherCollisionItem != collisionItem && selected != selectedIndices.end() &&
+                otherCollisionItem->X1() == endX && otherCollisionItem->Y1() == endY)
             {
-                collisionConnectData.emplace_back(
-                        CollisionConnectData(PropertyByName("Next", collisionItem->mProperties), collisionItem->Next(), otherId)
-                );
-
-                collisionConnectData.emplace_back(
-                        CollisionConnectData(PropertyByName("Previous", otherCollisionItem->mProperties), otherCollisionItem->Previous(), id)
-                );
+                nextCollisions.emplace_back(selected->second, otherCollisionItem);
             }
+        }
+        std::sort(nextCollisions.begin(), nextCollisions.end());
 
-            if (startX == otherEndX && startY == otherEndY)
-            {
-                collisionConnectData.emplace_back(
-                        CollisionConnectData(PropertyByName("Next", otherCollisionItem->mProperties), otherCollisionItem->Next(), id)
-                );
-                collisionConnectData.emplace_back(
-                        CollisionConnectData(PropertyByName("Previous", collisionItem->mProperties), collisionItem->Previous(), otherId)
-                );
-            }
+        for (auto& [index, otherCollisionItem] : nextCollisions)
+        {
+            collisionConnectData.emplace_back(
+                    CollisionConnectData(collisionItem, &collisionItem->Property(WellKnownProperty::Next), collisionItem->Next(), otherCollisionItem->mId)
+            );
 
+            collisionConnectData.emplace_back(
+                    CollisionConnectData(otherCollisionItem, &otherCollisionItem->Property(WellKnownProperty::Previous), otherCollisionItem->Previous(), collisionItem->mId)
+            );
         }
     }
     return collisionConnectData;
@@ -6,12 +6,13 @@
 
 struct CollisionConnectData
 {
-    CollisionConnectData(ObjectProperty *mObjectProperty, int mOldValue, int mNewValue) : mObjectProperty(
-            mObjectProperty), mOldValue(mOldValue), mNewValue(mNewValue)
+    CollisionConnectData(CollisionObject *mCollision, ObjectProperty *mObjectProperty, int mOldValue, int mNewValue) : mCollision(mCollision),
+            mObjectProperty(mObjectProperty), mOldValue(mOldValue), mNewValue(mNewValue)
     {
 
     }
 
+    CollisionObject* mCollision;
     ObjectProperty* mObjectProperty;
     int mOldValue;
     int mNewValue;
@@ -26,7 +27,7 @@ public:
 
     void redo() override;
 
-    static std::vector<CollisionConnectData> getConnectCollisionsChanges(const std::vector<ResizeableArrowItem *> &collisions);
+    static std::vector<CollisionConnectData> getConnectCollisionsChanges(const Model& model, const std::vector<ResizeableArrowItem *> &collisions);
 
 private:
     std::vector<CollisionConnectData> mCollisionConnectData;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// A fast non cryptographic 64 bit hash of a stream of bytes. Only used to tell if a file has changed, the data can be
+// fed in any sized pieces and gives the same result as hashing it all at once.
+class ContentHasher final
+{
+public:
+    void Update(std::string_view data)
+    {
+        const char* p = data.data();
+        size_t len = data.size();
+        mLength += len;
+
+        // Top up a partial word left over from the last update
+        while (mPendingBytes != 0 && len > 0)
+        {
+            mPending |= static_cast<uint64_t>(static_cast<unsigned char>(*p++)) << (mPendingBytes * 8);
+            len--;
+            if (++mPendingBytes == 8)
+            {
+                MixWord(mPending);
+                mPending = 0;
+                mPendingBytes = 0;
+            }
+        }
+
+        while (len >= 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, p, 8);
+            MixWord(word);
+            p += 8;
+            len -= 8;
+        }
+
+        while (len > 0)
+        {
+            mPending |= static_cast<uint64_t>(static_cast<unsigned char>(*p++)) << (mPendingBytes * 8);
+            mPendingBytes++;
+            len--;
+        }
+    }
+
+    uint64_t Final() const
+    {
+        uint64_t hash = mHash ^ (mPending * kMul1) ^ mLength;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+private:
+    static constexpr uint64_t kMul1 = 0x9E3779B97F4A7C15ull;
+    static constexpr uint64_t kMul2 = 0xBF58476D1CE4E5B9ull;
+
+    void MixWord(uint64_t word)
+    {
+        word *= kMul1;
+        word ^= word >> 31;
+        mHash = ((mHash ^ word) * kMul2);
+        mHash = (mHash << 27) | (mHash >> 37);
+    }
+
+    uint64_t mHash = 0;
+    uint64_t mPending = 0;
+    size_t mPendingBytes = 0;
+    uint64_t mLength = 0;
+};
+
+inline uint64_t HashContent(std::string_view data)
+{
+    ContentHasher hasher;
+    hasher.Update(data);
+    return hasher.Final();
+}
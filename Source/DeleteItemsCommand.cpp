@@ -31,6 +31,8 @@ DeleteItemsCommand::~DeleteItemsCommand()
 
 void DeleteItemsCommand::undo()
 {
+    EditTransaction transaction(mTab, mGraphicsItemsToDelete.count());
+
     // add back to scene
     for (auto& item : mGraphicsItemsToDelete)
     {
@@ -40,14 +42,14 @@ void DeleteItemsCommand::undo()
     // add back to model
     for (auto& item : mRemovedCollisions)
     {
-        mTab->GetModel().CollisionItems().emplace_back(std::move(item));
+        mTab->GetModel().AddCollisionItem(std::move(item));
     }
     mRemovedCollisions.clear();
 
     // add back to model
     for (auto& item : mRemovedMapObjects)
     {
-        item.mContainingCamera->mMapObjects.push_back(std::move(item.mRemovedMapObject));
+        item.mContainingCamera->AddMapObject(std::move(item.mRemovedMapObject));
     }
     mRemovedMapObjects.clear();
 
@@ -59,13 +61,15 @@ void DeleteItemsCommand::undo()
         item->setSelected(true);
     }
 
-    mTab->GetScene().update();
     mTab->SyncPropertyEditor();
 }
 
 void DeleteItemsCommand::redo()
 {
+    EditTransaction transaction(mTab, mGraphicsItemsToDelete.count());
+
     // remove from scene
+    std::vector<CollisionObject*> collisionsToRemove;
     for (auto& item : mGraphicsItemsToDelete)
     {
         mTab->GetScene().removeItem(item);
@@ -73,22 +77,23 @@ void DeleteItemsCommand::redo()
         ResizeableArrowItem* pArrow = qgraphicsitem_cast<ResizeableArrowItem*>(item);
         if (pArrow)
         {
-            mRemovedCollisions.emplace_back(mTab->GetModel().RemoveCollisionItem(pArrow->GetCollisionItem()));
+            collisionsToRemove.push_back(pArrow->GetCollisionItem());
         }
 
         ResizeableRectItem* pRect = qgraphicsitem_cast<ResizeableRectItem*>(item);
         if (pRect)
         {
-            // todo: prevent double cam look up
             auto pCam = mTab->GetModel().GetContainingCamera(pRect->GetMapObject());
             mRemovedMapObjects.emplace_back(DeletedMapObject{ mTab->GetModel().TakeFromContainingCamera(pRect->GetMapObject()), pCam });
         }
     }
 
+    // remove from model, all at once so deleting many lines doesn't renumber the rest for each of them
+    mRemovedCollisions = mTab->GetModel().RemoveCollisionItems(collisionsToRemove);
+
     mAdded = false;
 
     // Select nothing after deleting the selection
     mTab->GetScene().clearSelection();
-    mTab->GetScene().update();
     mTab->SyncPropertyEditor();
 }
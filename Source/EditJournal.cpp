@@ -0,0 +1,725 @@
+#include "EditJournal.hpp"
+#include "BinaryStream.hpp"
+#include "ContentHash.hpp"
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+// Layout:
+// header: magic, version, hash of the json the edits apply to
+// records: size, hash of the record, then sections until the end of the record
+// Each section replaces the map info, one camera or collision by index, or all of the cameras or collisions. A camera
+// is written as its position, the camera and then its images if they changed, replaying a camera without images
+// takes them from the camera that was at the same position before.
+constexpr uint32_t kEditJournalMagic = 0x4A455451; // "QTEJ"
+constexpr uint32_t kEditJournalVersion = 2;
+
+enum class JournalSection : uint8_t
+{
+    MapInfo,
+    Camera,
+    AllCameras,
+    Collision,
+    AllCollisions,
+};
+
+constexpr auto kCompactInterval = std::chrono::minutes(5);
+
+static std::mutex gJournalsMutex;
+static std::vector<EditJournal*> gJournals;
+
+static void WriteSection(BinaryWriter& writer, JournalSection section)
+{
+    writer.Write(static_cast<uint8_t>(section));
+}
+
+static void WriteHeader(BinaryWriter& writer, uint64_t jsonHash)
+{
+    writer.Write(kEditJournalMagic);
+    writer.Write(kEditJournalVersion);
+    writer.Write(jsonHash);
+}
+
+static void WriteFramedRecord(BinaryWriter& writer, const std::string& record)
+{
+    writer.Write(static_cast<uint32_t>(record.size()));
+    writer.Write(HashContent(record));
+    writer.Data().append(record);
+}
+
+static void WriteCamera(BinaryWriter& writer, const Model& model, const Camera& camera, bool withImages)
+{
+    BinaryWriter cameraWriter;
+    model.SaveBinaryCamera(cameraWriter, camera);
+
+    writer.Write(static_cast<int32_t>(camera.mX));
+    writer.Write(static_cast<int32_t>(camera.mY));
+    writer.WriteString(cameraWriter.Data());
+    writer.Write(static_cast<uint8_t>(withImages));
+    if (withImages)
+    {
+        BinaryWriter imagesWriter;
+        Model::SaveBinaryCameraImages(imagesWriter, camera);
+        writer.WriteString(imagesWriter.Data());
+    }
+}
+
+static void WriteCollision(BinaryWriter& writer, const Model& model, const CollisionObject& collision)
+{
+    BinaryWriter collisionWriter;
+    model.SaveBinaryCollision(collisionWriter, collision);
+    writer.WriteString(collisionWriter.Data());
+}
+
+// Returns the payloads of every complete record, a crash while appending can only leave the last one torn
+static std::optional<std::vector<std::string>> ReadRecords(const QString& journalFileName, uint64_t& jsonHash)
+{
+    QFile file(journalFileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    const QByteArray data = file.readAll();
+    std::vector<std::string> records;
+    try
+    {
+        BinaryReader reader(data.constData(), static_cast<size_t>(data.size()));
+        if (reader.Read<uint32_t>() != kEditJournalMagic || reader.Read<uint32_t>() != kEditJournalVersion)
+        {
+            return {};
+        }
+        jsonHash = reader.Read<uint64_t>();
+
+        while (!reader.AtEnd())
+        {
+            const uint32_t size = reader.Read<uint32_t>();
+            const uint64_t hash = reader.Read<uint64_t>();
+            std::string record(reader.ReadBytes(size), size);
+            if (HashContent(record) != hash)
+            {
+                break;
+            }
+            records.push_back(std::move(record));
+        }
+    }
+    catch (const InvalidBinaryException&)
+    {
+        // Torn record at the end
+    }
+    return records;
+}
+
+static UP_Camera ReplayCamera(BinaryReader& reader, Model& model)
+{
+    reader.Read<int32_t>();
+    reader.Read<int32_t>();
+
+    const std::string cameraData = reader.ReadString();
+    BinaryReader cameraReader(cameraData.data(), cameraData.size());
+    UP_Camera camera = model.LoadBinaryCamera(cameraReader);
+
+    if (reader.Read<uint8_t>())
+    {
+        const std::string imagesData = reader.ReadString();
+        BinaryReader imagesReader(imagesData.data(), imagesData.size());
+        Model::LoadBinaryCameraImages(imagesReader, *camera);
+    }
+    else
+    {
+        // Cameras are only written without images when they still have the ones they had at the same position
+        const Camera* pOldCamera = model.CameraAt(camera->mX, camera->mY);
+        if (!pOldCamera)
+        {
+            throw InvalidBinaryException();
+        }
+        camera->mCameraImageandLayers = pOldCamera->mCameraImageandLayers;
+    }
+    return camera;
+}
+
+static UP_CollisionObject ReplayCollision(BinaryReader& reader, Model& model)
+{
+    const std::string collisionData = reader.ReadString();
+    BinaryReader collisionReader(collisionData.data(), collisionData.size());
+    return model.LoadBinaryCollision(collisionReader);
+}
+
+static void ReplayRecord(const std::string& record, Model& model)
+{
+    BinaryReader reader(record.data(), record.size());
+    while (!reader.AtEnd())
+    {
+        switch (static_cast<JournalSection>(reader.Read<uint8_t>()))
+        {
+        case JournalSection::MapInfo:
+        {
+            const std::string mapInfoData = reader.ReadString();
+            BinaryReader mapInfoReader(mapInfoData.data(), mapInfoData.size());
+            model.LoadBinaryMapInfo(mapInfoReader);
+            break;
+        }
+
+        case JournalSection::Camera:
+        {
+            const uint32_t index = reader.Read<uint32_t>();
+            if (index >= model.CameraItems().size())
+            {
+                throw InvalidBinaryException();
+            }
+            model.CameraItems()[index] = ReplayCamera(reader, model);
+            model.IndexCameras();
+            break;
+        }
+
+        case JournalSection::AllCameras:
+        {
+            // Build them all before replacing any so cameras without images can find the old ones
+            std::vector<UP_Camera> cameras(reader.Read<uint32_t>());
+            for (auto& camera : cameras)
+            {
+                camera = ReplayCamera(reader, model);
+            }
+            model.CameraItems() = std::move(cameras);
+            model.IndexCameras();
+            break;
+        }
+
+        case JournalSection::Collision:
+        {
+            const uint32_t index = reader.Read<uint32_t>();
+            if (index >= model.CollisionItems().size())
+            {
+                throw InvalidBinaryException();
+            }
+            model.CollisionItems()[index] = ReplayCollision(reader, model);
+            break;
+        }
+
+        case JournalSection::AllCollisions:
+        {
+            std::vector<UP_CollisionObject> collisions(reader.Read<uint32_t>());
+            for (auto& collision : collisions)
+            {
+                collision = ReplayCollision(reader, model);
+            }
+            model.CollisionItems() = std::move(collisions);
+            break;
+        }
+
+        default:
+            throw InvalidBinaryException();
+        }
+    }
+
+    // Nothing above looks lines up by id so the ids are only indexed once the record is applied
+    model.IndexCollisions();
+}
+
+EditJournal::EditJournal(const QString& jsonFileName, const Model& model, bool modelMatchesJson)
+    : mFileName(JournalFileName(jsonFileName)),
+    mJsonHash(model.JsonFileHash().value_or(0)),
+    mLock(std::make_unique<QLockFile>(LockFileName(jsonFileName)))
+{
+    StartWriter();
+    if (modelMatchesJson)
+    {
+        TakeState(model);
+    }
+    else
+    {
+        // Nothing recorded yet so everything is written as changed
+        Record(model);
+    }
+}
+
+EditJournal::EditJournal(const QString& jsonFileName, uint64_t jsonHash, State jsonState, const Model& model)
+    : mState(std::move(jsonState)),
+    mFileName(JournalFileName(jsonFileName)),
+    mJsonHash(jsonHash),
+    mLock(std::make_unique<QLockFile>(LockFileName(jsonFileName)))
+{
+    StartWriter();
+    Record(model);
+}
+
+void EditJournal::StartWriter()
+{
+    // Only a crashed editor leaves the lock behind, however long ago a live one took it
+    mLock->setStaleLockTime(0);
+    if (!mLock->tryLock(0))
+    {
+        // Another tab or editor is journalling the same json, its file is left alone and nothing is written here
+        return;
+    }
+    mOwned = true;
+
+    mWriter = std::thread(&EditJournal::WriterLoop, this);
+
+    std::lock_guard<std::mutex> lock(gJournalsMutex);
+    gJournals.push_back(this);
+}
+
+EditJournal::~EditJournal()
+{
+    if (!mOwned)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(gJournalsMutex);
+        gJournals.erase(std::find(gJournals.begin(), gJournals.end(), this));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mWakeUp.notify_one();
+    mWriter.join();
+
+    // Still holding the lock so no one else can have started on it
+    QFile::remove(mFileName);
+    mLock->unlock();
+}
+
+QString EditJournal::JournalFileName(const QString& jsonFileName)
+{
+    return jsonFileName + ".qtejournal";
+}
+
+QString EditJournal::LockFileName(const QString& jsonFileName)
+{
+    return JournalFileName(jsonFileName) + ".lock";
+}
+
+bool EditJournal::HasEdits(const QString& jsonFileName)
+{
+    uint64_t jsonHash = 0;
+    auto records = ReadRecords(JournalFileName(jsonFileName), jsonHash);
+    return records && !records->empty();
+}
+
+bool EditJournal::Replay(const QString& jsonFileName, Model& model)
+{
+    uint64_t jsonHash = 0;
+    auto records = ReadRecords(JournalFileName(jsonFileName), jsonHash);
+    if (!records || records->empty() || !model.JsonFileHash() || *model.JsonFileHash() != jsonHash)
+    {
+        return false;
+    }
+
+    for (const std::string& record : *records)
+    {
+        // Each section builds what it replaces before swapping it in, so a bad one leaves the model as the previous
+        // sections left it
+        try
+        {
+            ReplayRecord(record, model);
+        }
+        catch (const ModelException&)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+void EditJournal::FlushAll()
+{
+    std::lock_guard<std::mutex> lock(gJournalsMutex);
+    for (EditJournal* pJournal : gJournals)
+    {
+        pJournal->Flush();
+    }
+}
+
+EditJournal::CameraState EditJournal::MakeCameraState(const Camera& camera)
+{
+    CameraState state;
+    state.mCamera = &camera;
+    state.mId = camera.mId;
+    state.mName = camera.mName;
+    state.mX = camera.mX;
+    state.mY = camera.mY;
+    state.mImagesRevision = camera.mImagesRevision;
+    state.mMapObjects.reserve(camera.mMapObjects.size());
+    for (const auto& mapObject : camera.mMapObjects)
+    {
+        state.mMapObjects.emplace_back(mapObject.get(), mapObject->mRevision);
+    }
+    return state;
+}
+
+bool EditJournal::SameCamera(const CameraState& state, const Camera& camera)
+{
+    if (state.mId != camera.mId || state.mName != camera.mName || state.mX != camera.mX || state.mY != camera.mY ||
+        state.mImagesRevision != camera.mImagesRevision || state.mMapObjects.size() != camera.mMapObjects.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < camera.mMapObjects.size(); i++)
+    {
+        const MapObject* pMapObject = camera.mMapObjects[i].get();
+        if (state.mMapObjects[i].first != pMapObject || state.mMapObjects[i].second != pMapObject->mRevision)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EditJournal::TakeState(const Model& model)
+{
+    BinaryWriter mapInfoWriter;
+    model.SaveBinaryMapInfo(mapInfoWriter);
+    mState.mMapInfo = std::move(mapInfoWriter.Data());
+
+    mState.mCameras.clear();
+    for (const auto& camera : model.GetCameras())
+    {
+        mState.mCameras.push_back(MakeCameraState(*camera));
+    }
+
+    mState.mCollisions.clear();
+    for (const auto& collision : model.GetCollisions())
+    {
+        mState.mCollisions.push_back({ collision.get(), collision->mId, collision->mRevision });
+    }
+}
+
+void EditJournal::Record(const Model& model)
+{
+    BinaryWriter writer;
+
+    BinaryWriter mapInfoWriter;
+    model.SaveBinaryMapInfo(mapInfoWriter);
+    if (mapInfoWriter.Data() != mState.mMapInfo)
+    {
+        WriteSection(writer, JournalSection::MapInfo);
+        writer.WriteString(mapInfoWriter.Data());
+        mState.mMapInfo = std::move(mapInfoWriter.Data());
+    }
+
+    const auto& cameras = model.GetCameras();
+    bool sameCameras = cameras.size() == mState.mCameras.size();
+    for (size_t i = 0; sameCameras && i < cameras.size(); i++)
+    {
+        sameCameras = cameras[i].get() == mState.mCameras[i].mCamera;
+    }
+
+    if (sameCameras)
+    {
+        for (size_t i = 0; i < cameras.size(); i++)
+        {
+            if (!SameCamera(mState.mCameras[i], *cameras[i]))
+            {
+                WriteSection(writer, JournalSection::Camera);
+                writer.Write(static_cast<uint32_t>(i));
+                WriteCamera(writer, model, *cameras[i], mState.mCameras[i].mImagesRevision != cameras[i]->mImagesRevision);
+                mState.mCameras[i] = MakeCameraState(*cameras[i]);
+            }
+        }
+    }
+    else
+    {
+        // Cameras were added, removed or swapped for new ones. Those we had before keep their images if they didn't
+        // change, as replaying finds them at the same position.
+        std::unordered_map<const Camera*, const CameraState*> oldCameras;
+        for (const CameraState& state : mState.mCameras)
+        {
+            oldCameras[state.mCamera] = &state;
+        }
+
+        WriteSection(writer, JournalSection::AllCameras);
+        writer.Write(static_cast<uint32_t>(cameras.size()));
+        std::vector<CameraState> newCameras;
+        newCameras.reserve(cameras.size());
+        for (const auto& camera : cameras)
+        {
+            auto it = oldCameras.find(camera.get());
+            const bool sameImages = it != oldCameras.end() &&
+                it->second->mImagesRevision == camera->mImagesRevision &&
+                it->second->mX == camera->mX && it->second->mY == camera->mY;
+            WriteCamera(writer, model, *camera, !sameImages);
+            newCameras.push_back(MakeCameraState(*camera));
+        }
+        mState.mCameras = std::move(newCameras);
+    }
+
+    const auto& collisions = model.GetCollisions();
+    bool sameCollisions = collisions.size() == mState.mCollisions.size();
+    for (size_t i = 0; sameCollisions && i < collisions.size(); i++)
+    {
+        sameCollisions = collisions[i].get() == mState.mCollisions[i].mCollision && collisions[i]->mId == mState.mCollisions[i].mId;
+    }
+
+    if (sameCollisions)
+    {
+        for (size_t i = 0; i < collisions.size(); i++)
+        {
+            if (mState.mCollisions[i].mRevision != collisions[i]->mRevision)
+            {
+                WriteSection(writer, JournalSection::Collision);
+                writer.Write(static_cast<uint32_t>(i));
+                WriteCollision(writer, model, *collisions[i]);
+                mState.mCollisions[i].mRevision = collisions[i]->mRevision;
+            }
+        }
+    }
+    else
+    {
+        WriteSection(writer, JournalSection::AllCollisions);
+        writer.Write(static_cast<uint32_t>(collisions.size()));
+        mState.mCollisions.clear();
+        for (const auto& collision : collisions)
+        {
+            WriteCollision(writer, model, *collision);
+            mState.mCollisions.push_back({ collision.get(), collision->mId, collision->mRevision });
+        }
+    }
+
+    if (writer.Data().empty() || !mOwned)
+    {
+        // Selection changes and the like, or the journal belongs to someone else. The state is still kept up to
+        // date for any journal started from it after a save.
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(writer.Data()));
+    }
+    mWakeUp.notify_one();
+}
+
+void EditJournal::Flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this]() { return mQueue.empty() && !mBusy; });
+}
+
+void EditJournal::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto compactTime = std::chrono::steady_clock::now() + kCompactInterval;
+    for (;;)
+    {
+        mIdle.notify_all();
+        const bool woken = mWakeUp.wait_until(lock, compactTime, [this]() { return !mQueue.empty() || mQuit; });
+
+        if (!woken)
+        {
+            mBusy = true;
+            lock.unlock();
+            Compact();
+            lock.lock();
+            mBusy = false;
+            compactTime = std::chrono::steady_clock::now() + kCompactInterval;
+            continue;
+        }
+
+        if (mQueue.empty())
+        {
+            // Quitting, anything queued was written first
+            return;
+        }
+
+        std::string record = std::move(mQueue.front());
+        mQueue.pop_front();
+        mBusy = true;
+        lock.unlock();
+        ApplyToSnapshot(record);
+        WriteRecord(record);
+        lock.lock();
+        mBusy = false;
+    }
+}
+
+void EditJournal::WriteRecord(const std::string& record)
+{
+    mRecordsSinceCompact++;
+    if (!mFileStarted)
+    {
+        // Replaces any journal left from before, which was either replayed or thrown away. This is also how we catch
+        // up after a failed write.
+        WriteWholeFile(SnapshotRecord());
+        return;
+    }
+
+    BinaryWriter writer;
+    WriteFramedRecord(writer, record);
+
+    QFile file(mFileName);
+    mFileStarted = file.open(QIODevice::Append) &&
+        file.write(writer.Data().data(), static_cast<qint64>(writer.Data().size())) == static_cast<qint64>(writer.Data().size());
+}
+
+void EditJournal::ApplyToSnapshot(const std::string& record)
+{
+    // The record was made by Record() so this can skip over the cameras and collisions without parsing them
+    auto fnReadCamera = [](BinaryReader& reader)
+    {
+        CameraEntry entry;
+        entry.mX = reader.Read<int32_t>();
+        entry.mY = reader.Read<int32_t>();
+        entry.mCamera = reader.ReadString();
+        if (reader.Read<uint8_t>())
+        {
+            entry.mImages = reader.ReadString();
+        }
+        return entry;
+    };
+
+    // A camera without images has the ones from the camera at the same position, if that was changed then it's in
+    // here, otherwise it's the json camera and replaying finds it the same way
+    auto fnKeepImages = [this](CameraEntry& entry)
+    {
+        if (entry.mImages)
+        {
+            return;
+        }
+
+        for (const auto& [index, oldEntry] : mSnapshot.mCameras)
+        {
+            if (oldEntry.mX == entry.mX && oldEntry.mY == entry.mY)
+            {
+                entry.mImages = oldEntry.mImages;
+                break;
+            }
+        }
+    };
+
+    BinaryReader reader(record.data(), record.size());
+    while (!reader.AtEnd())
+    {
+        switch (static_cast<JournalSection>(reader.Read<uint8_t>()))
+        {
+        case JournalSection::MapInfo:
+            mSnapshot.mMapInfo = reader.ReadString();
+            break;
+
+        case JournalSection::Camera:
+        {
+            const uint32_t index = reader.Read<uint32_t>();
+            CameraEntry entry = fnReadCamera(reader);
+            fnKeepImages(entry);
+            mSnapshot.mCameras[index] = std::move(entry);
+            break;
+        }
+
+        case JournalSection::AllCameras:
+        {
+            std::map<uint32_t, CameraEntry> cameras;
+            const uint32_t count = reader.Read<uint32_t>();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                CameraEntry entry = fnReadCamera(reader);
+                fnKeepImages(entry);
+                cameras[i] = std::move(entry);
+            }
+            mSnapshot.mCameras = std::move(cameras);
+            mSnapshot.mAllCameras = true;
+            break;
+        }
+
+        case JournalSection::Collision:
+        {
+            const uint32_t index = reader.Read<uint32_t>();
+            mSnapshot.mCollisions[index] = reader.ReadString();
+            break;
+        }
+
+        case JournalSection::AllCollisions:
+        {
+            std::map<uint32_t, std::string> collisions;
+            const uint32_t count = reader.Read<uint32_t>();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                collisions[i] = reader.ReadString();
+            }
+            mSnapshot.mCollisions = std::move(collisions);
+            mSnapshot.mAllCollisions = true;
+            break;
+        }
+        }
+    }
+}
+
+std::string EditJournal::SnapshotRecord() const
+{
+    BinaryWriter writer;
+    if (mSnapshot.mMapInfo)
+    {
+        WriteSection(writer, JournalSection::MapInfo);
+        writer.WriteString(*mSnapshot.mMapInfo);
+    }
+
+    if (mSnapshot.mAllCameras)
+    {
+        WriteSection(writer, JournalSection::AllCameras);
+        writer.Write(static_cast<uint32_t>(mSnapshot.mCameras.size()));
+    }
+    for (const auto& [index, entry] : mSnapshot.mCameras)
+    {
+        if (!mSnapshot.mAllCameras)
+        {
+            WriteSection(writer, JournalSection::Camera);
+            writer.Write(index);
+        }
+        writer.Write(entry.mX);
+        writer.Write(entry.mY);
+        writer.WriteString(entry.mCamera);
+        writer.Write(static_cast<uint8_t>(entry.mImages.has_value()));
+        if (entry.mImages)
+        {
+            writer.WriteString(*entry.mImages);
+        }
+    }
+
+    if (mSnapshot.mAllCollisions)
+    {
+        WriteSection(writer, JournalSection::AllCollisions);
+        writer.Write(static_cast<uint32_t>(mSnapshot.mCollisions.size()));
+    }
+    for (const auto& [index, collision] : mSnapshot.mCollisions)
+    {
+        if (!mSnapshot.mAllCollisions)
+        {
+            WriteSection(writer, JournalSection::Collision);
+            writer.Write(index);
+        }
+        writer.WriteString(collision);
+    }
+    return std::move(writer.Data());
+}
+
+void EditJournal::Compact()
+{
+    if (mFileStarted && mRecordsSinceCompact > 1)
+    {
+        WriteWholeFile(SnapshotRecord());
+    }
+}
+
+void EditJournal::WriteWholeFile(const std::string& record)
+{
+    BinaryWriter writer;
+    WriteHeader(writer, mJsonHash);
+    WriteFramedRecord(writer, record);
+
+    // Written to a temp file that replaces the journal so a crash can't leave it half written
+    QSaveFile file(mFileName);
+    mFileStarted = file.open(QIODevice::WriteOnly) &&
+        file.write(writer.Data().data(), static_cast<qint64>(writer.Data().size())) == static_cast<qint64>(writer.Data().size()) &&
+        file.commit();
+    if (mFileStarted)
+    {
+        mRecordsSinceCompact = 1;
+    }
+}
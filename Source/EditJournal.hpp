@@ -0,0 +1,145 @@
+#pragma once
+
+#include <QString>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Model.hpp"
+
+class QLockFile;
+
+// Keeps a record of unsaved edits in <json>.qtejournal so they can be restored if the editor dies before they are
+// saved. Record() is called after every undo/redo and only serialises the cameras, collisions and map info that
+// changed since the last call, which it finds by comparing pointers and revisions against what it last saw. The file
+// is written on a thread of its own which also compacts it every few minutes, so an edit only costs building its
+// record on the GUI thread. The journal is locked with <json>.qtejournal.lock for as long as it's open, so a second
+// tab or editor with the same json open doesn't write to or delete a journal that isn't its own.
+class EditJournal final
+{
+private:
+    struct CameraState final
+    {
+        const Camera* mCamera = nullptr;
+        int mId = 0;
+        std::string mName;
+        int mX = 0;
+        int mY = 0;
+        uint64_t mImagesRevision = 0;
+        std::vector<std::pair<const MapObject*, uint64_t>> mMapObjects;
+    };
+
+    struct CollisionState final
+    {
+        const CollisionObject* mCollision = nullptr;
+        int mId = 0;
+        uint64_t mRevision = 0;
+    };
+
+public:
+    // What the journal last recorded of the model
+    struct State final
+    {
+        std::string mMapInfo;
+        std::vector<CameraState> mCameras;
+        std::vector<CollisionState> mCollisions;
+    };
+
+    // Starts a journal for a model loaded from or saved to the json. If the model holds edits that aren't in the json,
+    // such as ones just restored from an old journal, pass false so they are all written out straight away.
+    EditJournal(const QString& jsonFileName, const Model& model, bool modelMatchesJson);
+
+    // Starts a journal for a json that was saved from the model as it was when jsonState was recorded, anything
+    // edited since is in the first record
+    EditJournal(const QString& jsonFileName, uint64_t jsonHash, State jsonState, const Model& model);
+
+    // Deletes the journal file, the edits were either saved or the user threw them away
+    ~EditJournal();
+
+    static QString JournalFileName(const QString& jsonFileName);
+    static QString LockFileName(const QString& jsonFileName);
+
+    // False if another tab or editor already had a journal for the json, this one then records nothing
+    bool Owned() const
+    {
+        return mOwned;
+    }
+
+    // True if there is a journal for the json with any edits in it
+    static bool HasEdits(const QString& jsonFileName);
+
+    // Applies the edits in the journal for the json to the model, which must have been loaded from that json. Returns
+    // false if there was nothing to apply or the json was changed after the journal was started.
+    static bool Replay(const QString& jsonFileName, Model& model);
+
+    // Waits for every journal to finish writing, for when we are about to exit without unwinding
+    static void FlushAll();
+
+    void Record(const Model& model);
+
+    const State& RecordedState() const
+    {
+        return mState;
+    }
+
+private:
+    static CameraState MakeCameraState(const Camera& camera);
+    static bool SameCamera(const CameraState& state, const Camera& camera);
+    void StartWriter();
+    void TakeState(const Model& model);
+
+    State mState;
+
+    // A camera as the writer thread keeps it, the position is copied out so it can match cameras without parsing them
+    struct CameraEntry final
+    {
+        int32_t mX = 0;
+        int32_t mY = 0;
+        std::string mCamera;
+        std::optional<std::string> mImages;
+    };
+
+    // Everything the records so far changed, compacting replaces the records with this
+    struct Snapshot final
+    {
+        std::optional<std::string> mMapInfo;
+
+        // Until a record replaces all of them the cameras and collisions are changes to the json ones by index
+        bool mAllCameras = false;
+        std::map<uint32_t, CameraEntry> mCameras;
+        bool mAllCollisions = false;
+        std::map<uint32_t, std::string> mCollisions;
+    };
+
+    void Flush();
+    void WriterLoop();
+    void WriteRecord(const std::string& record);
+    void ApplyToSnapshot(const std::string& record);
+    std::string SnapshotRecord() const;
+    void Compact();
+    void WriteWholeFile(const std::string& record);
+
+    const QString mFileName;
+    const uint64_t mJsonHash;
+    const std::unique_ptr<QLockFile> mLock;
+    bool mOwned = false;
+
+    // Only used by the writer thread
+    Snapshot mSnapshot;
+    bool mFileStarted = false;
+    int mRecordsSinceCompact = 0;
+
+    std::mutex mMutex;
+    std::condition_variable mWakeUp;
+    std::condition_variable mIdle;
+    std::deque<std::string> mQueue;
+    bool mBusy = false;
+    bool mQuit = false;
+    std::thread mWriter;
+};
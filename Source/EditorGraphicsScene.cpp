@@ -18,26 +18,117 @@ EditorGraphicsScene::EditorGraphicsScene(EditorTab* pTab)
 
 QList<ResizeableRectItem*> EditorGraphicsScene::MapObjectsForCamera(CameraGraphicsItem* pCameraGraphicsItem)
 {
-    const auto& modelMapObjects = pCameraGraphicsItem->GetCamera()->mMapObjects;
+    const Camera* pCamera = pCameraGraphicsItem->GetCamera();
 
     QList<ResizeableRectItem*> graphicsItemMapObjects;
-    QList<QGraphicsItem*> allItems = items();
-    for (QGraphicsItem* item : allItems)
+    for (const auto& mapObject : pCamera->mMapObjects)
+    {
+        ResizeableRectItem* pItem = ItemForMapObject(mapObject->mId);
+        if (pItem)
+        {
+            graphicsItemMapObjects.append(pItem);
+        }
+    }
+    return graphicsItemMapObjects;
+}
+
+ResizeableRectItem* EditorGraphicsScene::ItemForMapObject(int mapObjectId) const
+{
+    const auto it = mMapObjectItems.find(mapObjectId);
+    return it != mMapObjectItems.end() ? it->second : nullptr;
+}
+
+ResizeableArrowItem* EditorGraphicsScene::ItemForCollision(int collisionId) const
+{
+    const auto it = mCollisionItems.find(collisionId);
+    return it != mCollisionItems.end() ? it->second : nullptr;
+}
+
+void EditorGraphicsScene::OnModelChanged(const std::vector<ModelChange>& changes)
+{
+    for (const ModelChange& change : changes)
     {
-        ResizeableRectItem* pCastedGraphicsItemMapObject = qgraphicsitem_cast<ResizeableRectItem*>(item);
-        if (pCastedGraphicsItemMapObject)
+        switch (change.mKind)
         {
-            for (auto& mapModelObj : modelMapObjects)
+        case ModelChange::MapObjectChanged:
+            if (ResizeableRectItem* pItem = ItemForMapObject(change.mId))
             {
-                if (mapModelObj.get() == pCastedGraphicsItemMapObject->GetMapObject())
-                {
-                    graphicsItemMapObjects.append(pCastedGraphicsItemMapObject);
-                    break;
-                }
+                pItem->SyncInternalObject();
+                pItem->update();
+            }
+            break;
+
+        case ModelChange::CollisionChanged:
+            if (ResizeableArrowItem* pItem = ItemForCollision(change.mId))
+            {
+                pItem->SyncInternalObject();
+                pItem->update();
             }
+            break;
+
+        case ModelChange::CameraChanged:
+        case ModelChange::CameraImagesChanged:
+        {
+            // Only the camera's cell has to be drawn again
+            const MapInfo& mapInfo = mTab->GetModel().GetMapInfo();
+            update(change.mCamera->mX * mapInfo.mXGridSize, change.mCamera->mY * mapInfo.mYGridSize, mapInfo.mXGridSize, mapInfo.mYGridSize);
+            break;
+        }
+
+        default:
+            break;
         }
     }
-    return graphicsItemMapObjects;
+}
+
+void EditorGraphicsScene::BeginBulkEdit(int itemCount)
+{
+    // Each item added to or removed from the BSP tree costs a walk of the tree, once enough of the scene changes
+    // it's cheaper to go without the tree until the edit is done and build it again from scratch
+    const int kMinBulkItemCount = 256;
+    const size_t sceneItemCount = mMapObjectItems.size() + mCollisionItems.size();
+    if (itemCount >= kMinBulkItemCount && static_cast<size_t>(itemCount) * 8 >= sceneItemCount && itemIndexMethod() == QGraphicsScene::BspTreeIndex)
+    {
+        setItemIndexMethod(QGraphicsScene::NoIndex);
+        mIndexSuspended = true;
+    }
+}
+
+void EditorGraphicsScene::EndBulkEdit()
+{
+    if (mIndexSuspended)
+    {
+        setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+        mIndexSuspended = false;
+    }
+}
+
+void EditorGraphicsScene::RegisterItem(ResizeableRectItem* pItem)
+{
+    mMapObjectItems[pItem->GetMapObject()->mId] = pItem;
+}
+
+void EditorGraphicsScene::UnregisterItem(ResizeableRectItem* pItem)
+{
+    const auto it = mMapObjectItems.find(pItem->GetMapObject()->mId);
+    if (it != mMapObjectItems.end() && it->second == pItem)
+    {
+        mMapObjectItems.erase(it);
+    }
+}
+
+void EditorGraphicsScene::RegisterItem(ResizeableArrowItem* pItem)
+{
+    mCollisionItems[pItem->GetCollisionItem()->mId] = pItem;
+}
+
+void EditorGraphicsScene::UnregisterItem(ResizeableArrowItem* pItem)
+{
+    const auto it = mCollisionItems.find(pItem->GetCollisionItem()->mId);
+    if (it != mCollisionItems.end() && it->second == pItem)
+    {
+        mCollisionItems.erase(it);
+    }
 }
 
 void EditorGraphicsScene::UpdateSceneRect()
@@ -65,6 +156,22 @@ CameraGraphicsItem* EditorGraphicsScene::CameraAt(int x, int y)
     return nullptr;
 }
 
+std::map<std::pair<int, int>, CameraGraphicsItem*> EditorGraphicsScene::CameraItemsByPosition()
+{
+    std::map<std::pair<int, int>, CameraGraphicsItem*> cameraItems;
+    QList<QGraphicsItem*> allItems = items();
+    for (QGraphicsItem* item : allItems)
+    {
+        CameraGraphicsItem* pCameraItem = qgraphicsitem_cast<CameraGraphicsItem*>(item);
+        if (pCameraItem)
+        {
+            // Same as CameraAt(), the first one found wins
+            cameraItems.emplace(std::make_pair(pCameraItem->GetCamera()->mX, pCameraItem->GetCamera()->mY), pCameraItem);
+        }
+    }
+    return cameraItems;
+}
+
 TransparencySettings& EditorGraphicsScene::GetTransparencySettings()
 {
     return mTransparencySettings;
@@ -304,6 +411,9 @@ void ItemPositionData::Save(QList<QGraphicsItem*>& items, Model& model, bool rec
 
 void ItemPositionData::Restore(Model& model)
 {
+    // Setting the rect or line of an item syncs it to the model a value at a time
+    ModelChangeBatch batch(model);
+
     for (auto& [rect, pos] : mRects)
     {
         rect->SetRect(pos.rect);
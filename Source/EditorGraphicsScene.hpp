@@ -3,12 +3,15 @@
 #include <QGraphicsScene>
 #include <QKeyEvent>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 class ResizeableArrowItem;
 class ResizeableRectItem;
 class CameraGraphicsItem;
 class Model;
 struct Camera;
+struct ModelChange;
 class EditorTab;
 
 class ItemPositionData final
@@ -144,6 +147,26 @@ public:
 
     CameraGraphicsItem* CameraAt(int x, int y);
 
+    // Every camera item by the position of its camera, for when many are looked up at once
+    std::map<std::pair<int, int>, CameraGraphicsItem*> CameraItemsByPosition();
+
+    // The item showing the object or line with the id, null if it isn't in the scene
+    ResizeableRectItem* ItemForMapObject(int mapObjectId) const;
+    ResizeableArrowItem* ItemForCollision(int collisionId) const;
+
+    // Items call these as they are added to or removed from the scene
+    void RegisterItem(ResizeableRectItem* pItem);
+    void UnregisterItem(ResizeableRectItem* pItem);
+    void RegisterItem(ResizeableArrowItem* pItem);
+    void UnregisterItem(ResizeableArrowItem* pItem);
+
+    // Shows edits to objects, lines and cameras that didn't come from moving their items
+    void OnModelChanged(const std::vector<ModelChange>& changes);
+
+    // For adding, removing or moving itemCount items at once, see EditorTab::BeginTransaction()
+    void BeginBulkEdit(int itemCount);
+    void EndBulkEdit();
+
     TransparencySettings& GetTransparencySettings();
 
     void SyncTransparencySettings();
@@ -169,4 +192,11 @@ private:
     bool mLeftButtonDown = false;
     TransparencySettings mTransparencySettings;
     bool mGridEnabled = false;
+
+    // By MapObject::mId and CollisionObject::mId
+    std::unordered_map<int, ResizeableRectItem*> mMapObjectItems;
+    std::unordered_map<int, ResizeableArrowItem*> mCollisionItems;
+
+    // Set while a bulk edit has turned off the index of items
+    bool mIndexSuspended = false;
 };
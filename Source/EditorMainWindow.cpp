@@ -18,9 +18,15 @@
 #include "qactiongroup.h"
 #include "ReliveApiWrapper.hpp"
 #include "ShowContext.hpp"
+#include "ModelCache.hpp"
+#include "EditJournal.hpp"
+#include <QLockFile>
 
 static void FatalError(const char* msg)
 {
+    // Nothing gets saved after this so make sure the edits are at least in the journals
+    EditJournal::FlushAll();
+
     QMessageBox::critical(nullptr, "Unrecoverable error", msg);
     exit(EXIT_FAILURE);
 }
@@ -93,6 +99,8 @@ EditorMainWindow::EditorMainWindow(QWidget* aParent)
 
     QPixmapCache::setCacheLimit(1024 * 50);
 
+    RestoreEditJournals();
+
     QStringList files;
     files.append("C:/GitHub/qt-editor/build/Debug/level/OutputAE_ba.lvl_4.json");
     files.append("C:/GitHub/qt-editor/build/Debug/level/OutputAO_f1.lvl_2.json");
@@ -138,6 +146,8 @@ void EditorMainWindow::readSettings()
     {
         restoreState(m_Settings.value("windowState").toByteArray());
     }
+
+    m_ui->action_model_cache->setChecked(m_Settings.value("model_cache", true).toBool());
 }
 
 void EditorMainWindow::setMenuActionsEnabled(bool enable)
@@ -165,8 +175,64 @@ void EditorMainWindow::setMenuActionsEnabled(bool enable)
     }
 }
 
-bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
+void EditorMainWindow::RestoreEditJournals()
+{
+    // Journals are deleted when their tab closes so any left behind are from a crash, or belong to another editor
+    // that is still running. Paths opened from now on add themselves back.
+    const QStringList journals = m_Settings.value("edit_journals").toStringList();
+    m_Settings.remove("edit_journals");
+
+    for (const QString& jsonFileName : journals)
+    {
+        // A journal is only deleted by whoever holds its lock, so one that is still being written is left alone
+        QLockFile lock(EditJournal::LockFileName(jsonFileName));
+        lock.setStaleLockTime(0);
+        if (!lock.tryLock(0))
+        {
+            AddEditJournal(jsonFileName);
+            continue;
+        }
+
+        if (!EditJournal::HasEdits(jsonFileName))
+        {
+            QFile::remove(EditJournal::JournalFileName(jsonFileName));
+            continue;
+        }
+
+        if (QMessageBox::question(this, "Restore unsaved changes", "The editor closed without saving the changes to " + jsonFileName + ".\nDo you want to restore them?") != QMessageBox::Yes)
+        {
+            QFile::remove(EditJournal::JournalFileName(jsonFileName));
+            continue;
+        }
+
+        // The tab's journal takes the lock over once the edits are replayed
+        lock.unlock();
+        if (!onOpenPath(jsonFileName, false, true))
+        {
+            // Keep it so they can try again next time
+            AddEditJournal(jsonFileName);
+        }
+    }
+}
+
+void EditorMainWindow::AddEditJournal(QString jsonFileName)
 {
+    QStringList journals = m_Settings.value("edit_journals").toStringList();
+    if (!journals.contains(jsonFileName))
+    {
+        journals.append(jsonFileName);
+        m_Settings.setValue("edit_journals", journals);
+    }
+}
+
+bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath, bool restoreEditJournal)
+{
+    if (!IsJsonFileNameSupported(fullFileName.toStdString()))
+    {
+        QMessageBox::critical(this, "Error", kNoGzipSupportMessage);
+        return false;
+    }
+
     int newPathId = 0;
     bool isTempfile = false;
     bool isUpgraded = false;
@@ -266,9 +332,21 @@ bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
 
     try
     {
-        // Load the json file into the editors object model
-        auto model = std::make_unique<Model>();
-        model->LoadJsonFromFile(fullFileName.toStdString());
+        // Use the cache if it's still up to date with the json, temp files are deleted after loading so never have one
+        const bool useModelCache = m_ui->action_model_cache->isChecked();
+        UP_Model model;
+        if (useModelCache && !isTempfile)
+        {
+            model = LoadModelCache(fullFileName);
+        }
+
+        const bool cached = model != nullptr;
+        if (!cached)
+        {
+            // Load the json file into the editors object model
+            model = std::make_unique<Model>();
+            model->LoadJsonFromFile(fullFileName.toStdString());
+        }
 
         if (model->GetMapInfo().mApiVersion > ReliveAPI::GetApiVersion())
         {
@@ -300,6 +378,16 @@ bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
             model->CreateAsNewPath(newPathId);
         }
 
+        bool restoredEdits = false;
+        if (restoreEditJournal)
+        {
+            restoredEdits = EditJournal::Replay(fullFileName, *model);
+            if (!restoredEdits)
+            {
+                QMessageBox::warning(this, "Warning", "Unsaved changes to " + fullFileName + " could not be restored because the json was changed after they were made");
+            }
+        }
+
         // If exported to a temp file then delete it now we've loaded it to memory
         if (isTempfile)
         {
@@ -312,12 +400,19 @@ bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
         }
 
         EditorTab* view = new EditorTab(m_ui->tabWidget, std::move(model), fullFileName, isTempfile, statusBar(), mSnapSettings);
+        view->SetModelCacheEnabled(useModelCache);
 
         connect(
             view, &EditorTab::CleanChanged,
             this, &EditorMainWindow::UpdateWindowTitle
         );
 
+        connect(
+            view, &EditorTab::EditJournalStarted,
+            this, &EditorMainWindow::AddEditJournal
+        );
+        view->StartEditJournal(restoredEdits);
+
         QFileInfo fileInfo(fullFileName);
         const int tabIdx = m_ui->tabWidget->addTab(view, fileInfo.fileName());
         m_ui->tabWidget->setTabToolTip(tabIdx, fullFileName);
@@ -329,8 +424,13 @@ bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
         view->UpdateTabTitle(view->IsClean());
         if (isUpgraded)
         {
+            // Saving writes the cache too
             view->Save();
         }
+        else if (!cached && !restoredEdits)
+        {
+            view->WriteModelCache();
+        }
         setMenuActionsEnabled(true);
 
         return true;
@@ -340,6 +440,11 @@ bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
         QMessageBox::critical(this, "Error", QString("Key missing from json: ") + e.Key().c_str());
         return false;
     }
+    catch (const EnumValueNotFoundException& e)
+    {
+        QMessageBox::critical(this, "Error", QString("Value ") + e.Value().c_str() + " in json isn't one of the values of " + e.EnumName().c_str());
+        return false;
+    }
     catch (const ModelException&)
     {
         QMessageBox::critical(this, "Error", "Failed to load json");
@@ -350,6 +455,7 @@ bool EditorMainWindow::onOpenPath(QString fullFileName, bool createNewPath)
 void EditorMainWindow::onCloseTab(int index)
 {
     auto tab = static_cast<EditorTab*>(m_ui->tabWidget->widget(index));
+    tab->FinishSave();
 
     bool close = true;
     if (!tab->IsClean())
@@ -443,7 +549,12 @@ void EditorMainWindow::on_action_about_triggered()
 void EditorMainWindow::on_action_open_path_triggered()
 {
     QString lastOpenDir = m_Settings.value("last_open_dir").toString();
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Open level"), lastOpenDir, tr("Supported Files (*.json *.lvl);; Json Files (*.json);;Level Files (*.lvl);;All Files (*)"));
+#ifdef QT_EDITOR_GZIP
+    const QString filter = tr("Supported Files (*.json *.json.gz *.lvl);; Json Files (*.json *.json.gz);;Level Files (*.lvl);;All Files (*)");
+#else
+    const QString filter = tr("Supported Files (*.json *.lvl);; Json Files (*.json);;Level Files (*.lvl);;All Files (*)");
+#endif
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open level"), lastOpenDir, filter);
     if (!fileName.isEmpty())
     {
         if (onOpenPath(fileName, false))
@@ -577,6 +688,11 @@ void EditorMainWindow::closeEvent(QCloseEvent* pEvent)
 {
     if (m_ui->tabWidget->count() > 0)
     {
+        for (int i = 0; i < m_ui->tabWidget->count(); i++)
+        {
+            static_cast<EditorTab*>(m_ui->tabWidget->widget(i))->FinishSave();
+        }
+
         bool anyTabsNeedSaving = false;
         for (int i = 0; i < m_ui->tabWidget->count(); i++)
         {
@@ -608,6 +724,7 @@ void EditorMainWindow::closeEvent(QCloseEvent* pEvent)
         {
         case QMessageBox::Save:
         {
+            // Start them all first so they save at the same time
             for (int i = 0; i < m_ui->tabWidget->count(); i++)
             {
                 if (!static_cast<EditorTab*>(m_ui->tabWidget->widget(i))->Save())
@@ -617,6 +734,15 @@ void EditorMainWindow::closeEvent(QCloseEvent* pEvent)
                 }
             }
 
+            for (int i = 0; i < m_ui->tabWidget->count(); i++)
+            {
+                if (!static_cast<EditorTab*>(m_ui->tabWidget->widget(i))->FinishSave())
+                {
+                    pEvent->ignore();
+                    return;
+                }
+            }
+
             // disconnect signals that will fire in our dtor and crash at shutdown
             DisconnectTabSignals();
 
@@ -800,7 +926,8 @@ void EditorMainWindow::on_actionCopy_triggered()
 
 void EditorMainWindow::on_actionPaste_triggered()
 {
-    if (!mClipBoard.IsEmpty())
+    // The items can come from another editor instance so they're read from the system clipboard each time
+    if (mClipBoard.Fetch())
     {
         EditorTab* pTab = getActiveTab(m_ui->tabWidget);
         if (pTab)
@@ -809,9 +936,20 @@ void EditorMainWindow::on_actionPaste_triggered()
             {
                 QMessageBox::critical(this, "Error", "You can't cut/copy paste data between AO and AE");
             }
+            else if (mClipBoard.SchemaHash() != pTab->GetModel().GetSchema()->Hash())
+            {
+                QMessageBox::critical(this, "Error", "You can't paste items copied from a path with a different schema");
+            }
             else
             {
-                pTab->Paste(mClipBoard);
+                try
+                {
+                    pTab->Paste(mClipBoard);
+                }
+                catch (const ModelException&)
+                {
+                    QMessageBox::critical(this, "Error", "Failed to read the items on the clipboard");
+                }
             }
         }
     }
@@ -836,3 +974,12 @@ void EditorMainWindow::on_action_snap_map_objects_y_toggled(bool on)
 {
     mSnapSettings.MapObjectSnapping().mSnapY = on;
 }
+
+void EditorMainWindow::on_action_model_cache_toggled(bool on)
+{
+    m_Settings.setValue("model_cache", on);
+    for (int i = 0; i < m_ui->tabWidget->count(); i++)
+    {
+        static_cast<EditorTab*>(m_ui->tabWidget->widget(i))->SetModelCacheEnabled(on);
+    }
+}
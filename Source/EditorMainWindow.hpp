@@ -90,10 +90,15 @@ private slots:
 
     void on_action_snap_map_objects_y_toggled(bool on);
 
+    void on_action_model_cache_toggled(bool on);
+
+    void AddEditJournal(QString jsonFileName);
+
 private:
     void readSettings();
     void setMenuActionsEnabled(bool enable);
-    bool onOpenPath(QString fileName, bool createNewPath);
+    bool onOpenPath(QString fileName, bool createNewPath, bool restoreEditJournal = false);
+    void RestoreEditJournals();
     void UpdateWindowTitle();
     void DisconnectTabSignals();
     void closeEvent(QCloseEvent* pEvent) override;
@@ -12,6 +12,7 @@
 #include <QMenu>
 #include <QStatusBar>
 #include <QFileDialog>
+#include <QCursor>
 #include "ResizeableArrowItem.hpp"
 #include "ResizeableRectItem.hpp"
 #include "CameraGraphicsItem.hpp"
@@ -33,7 +34,6 @@
 #include "AddObjectDialog.hpp"
 #include "SelectionSaver.hpp"
 #include "TransparencyDialog.hpp"
-#include "ProgressDialog.hpp"
 #include <QFutureWatcher>
 #include <QFuture>
 #include <QtConcurrent/QtConcurrent>
@@ -42,6 +42,10 @@
 #include "../../AliveLibAE/Grid.hpp"
 #include "../../AliveLibAO/Grid.hpp"
 #include "CollisionConnect.hpp"
+#include "EditJournal.hpp"
+#include "ReliveApiWrapper.hpp"
+#include "ModelCache.hpp"
+#include "ModelSnapshot.hpp"
 
 // Zoom by 10% each time.
 const float KZoomFactor = 0.10f;
@@ -79,7 +83,6 @@ public:
             {
                 item->setSelected(true);
             }
-            mScene->update();
         }
         mFirst = false;
         mTab->SyncPropertyEditor();
@@ -92,7 +95,6 @@ public:
         {
             item->setSelected(true);
         }
-        mScene->update();
         mTab->SyncPropertyEditor();
     }
 
@@ -108,9 +110,8 @@ private:
 class MoveItemsCommand final : public QUndoCommand
 {
 public:
-    MoveItemsCommand(QGraphicsScene* pScene, ItemPositionData oldPositions, ItemPositionData newPositions, Model& model)
-        : mScene(pScene),
-        mOldPositions(oldPositions),
+    MoveItemsCommand(ItemPositionData oldPositions, ItemPositionData newPositions, Model& model)
+        : mOldPositions(oldPositions),
         mNewPositions(newPositions),
         mModel(model)
     {
@@ -168,7 +169,6 @@ public:
         if (!mFirst)
         {
             mNewPositions.Restore(mModel);
-            mScene->update();
         }
         mFirst = false;
     }
@@ -176,11 +176,9 @@ public:
     void undo() override
     {
         mOldPositions.Restore(mModel);
-        mScene->update();
     }
 
 private:
-    QGraphicsScene* mScene = nullptr;
     ItemPositionData mOldPositions;
     ItemPositionData mNewPositions;
     Model& mModel;
@@ -333,9 +331,19 @@ private:
 };
 
 
+// A save running in the background and what it needs once it has finished
+struct EditorTab::PendingSave final
+{
+    QString mFileName;
+    uint64_t mUndoStackChanges = 0;
+    std::shared_ptr<const ModelSnapshot> mSnapshot;
+    std::optional<EditJournal::State> mJournalState;
+};
+
 EditorTab::EditorTab(QTabWidget* aParent, UP_Model model, QString jsonFileName, bool isTempFile, QStatusBar* pStatusBar, SnapSettings& snapSettings)
     : QMainWindow(aParent),
     ui(new Ui::EditorTab),
+    mArena(model->Arena()),
     mModel(std::move(model)),
     mJsonFileName(jsonFileName),
     mParent(aParent),
@@ -368,11 +376,30 @@ EditorTab::EditorTab(QTabWidget* aParent, UP_Model model, QString jsonFileName,
 
     connect(mScene.get(), &EditorGraphicsScene::ItemsMoved, this, [&](ItemPositionData oldPositions, ItemPositionData newPositions)
         {
-            mUndoStack.push(new MoveItemsCommand(mScene.get(), oldPositions, newPositions, *mModel));
+            mUndoStack.push(new MoveItemsCommand(oldPositions, newPositions, *mModel));
         });
 
     connect(&mUndoStack, &QUndoStack::cleanChanged, this, &EditorTab::cleanChanged);
 
+    connect(&mSaveWatcher, &QFutureWatcher<std::optional<uint64_t>>::finished, this, [&]()
+        {
+            // Unless FinishSave() already waited for it
+            if (mPendingSave)
+            {
+                SaveFinished();
+            }
+        });
+
+    // Fires for every push, undo and redo
+    connect(&mUndoStack, &QUndoStack::indexChanged, this, [&]()
+        {
+            mUndoStackChanges++;
+            if (mEditJournal)
+            {
+                mEditJournal->Record(*mModel);
+            }
+        });
+
     iZoomLevel = 1.0f;
     for (int i = 0; i < 2; ++i)
     {
@@ -397,6 +424,7 @@ EditorTab::EditorTab(QTabWidget* aParent, UP_Model model, QString jsonFileName,
         for (int y = 0; y < mapInfo.mYSize; y++)
         {
             Camera* pCam = mModel->CameraAt(x, y);
+
             auto pCameraGraphicsItem = MakeCameraGraphicsItem(pCam, mapInfo.mXGridSize * x, y *  mapInfo.mYGridSize, mapInfo.mXGridSize, mapInfo.mYGridSize);
             mScene->addItem(pCameraGraphicsItem);
 
@@ -424,7 +452,35 @@ EditorTab::EditorTab(QTabWidget* aParent, UP_Model model, QString jsonFileName,
     mUndoStack.setUndoLimit(100);
     ui->undoView->setStack(&mUndoStack);
 
-    static_cast<PropertyTreeWidget*>(ui->treeWidget)->Init();
+    auto pTree = static_cast<PropertyTreeWidget*>(ui->treeWidget);
+    pTree->Init();
+
+    // Each part of the tab only hears about the kinds of change it shows
+    mModelSubscriptions.push_back(mModel->Subscribe(ModelChange::MapObjectMoved | ModelChange::MapObjectChanged | ModelChange::CollisionMoved | ModelChange::CollisionChanged | ModelChange::CollisionRelinked,
+        [pTree](const std::vector<ModelChange>& changes)
+        {
+            pTree->OnModelChanged(changes);
+        }));
+
+    // Items move themselves so only other edits need syncing to them
+    mModelSubscriptions.push_back(mModel->Subscribe(ModelChange::MapObjectChanged | ModelChange::CollisionChanged | ModelChange::CameraChanged | ModelChange::CameraImagesChanged,
+        [this](const std::vector<ModelChange>& changes)
+        {
+            mScene->OnModelChanged(changes);
+        }));
+
+    mModelSubscriptions.push_back(mModel->Subscribe(ModelChange::CameraChanged,
+        [this](const std::vector<ModelChange>& changes)
+        {
+            // Update camera manager UI if open
+            if (mCameraManager)
+            {
+                for (const ModelChange& change : changes)
+                {
+                    mCameraManager->OnCameraIdChanged(change.mCamera);
+                }
+            }
+        }));
 
     addDockWidget(Qt::RightDockWidgetArea, ui->propertyDockWidget);
     addDockWidget(Qt::RightDockWidgetArea, ui->undoHistoryDockWidget);
@@ -438,12 +494,12 @@ EditorTab::EditorTab(QTabWidget* aParent, UP_Model model, QString jsonFileName,
 
 ResizeableRectItem* EditorTab::MakeResizeableRectItem(MapObject* pMapObject)
 {
-    return new ResizeableRectItem(ui->graphicsView, pMapObject, *static_cast<PropertyTreeWidget*>(ui->treeWidget), mScene->GetTransparencySettings().MapObjectTransparency(), mSnapSettings, *this);
+    return new ResizeableRectItem(ui->graphicsView, pMapObject, mScene->GetTransparencySettings().MapObjectTransparency(), mSnapSettings, *this);
 }
 
 ResizeableArrowItem* EditorTab::MakeResizeableArrowItem(CollisionObject* pCollisionObject)
 {
-    return new ResizeableArrowItem(ui->graphicsView, pCollisionObject, *static_cast<PropertyTreeWidget*>(ui->treeWidget), mScene->GetTransparencySettings().CollisionTransparency(), mSnapSettings, *this);
+    return new ResizeableArrowItem(ui->graphicsView, pCollisionObject, mScene->GetTransparencySettings().CollisionTransparency(), mSnapSettings, *this);
 }
 
 CameraGraphicsItem* EditorTab::MakeCameraGraphicsItem(Camera* pCamera, int x, int y, int w, int h)
@@ -453,6 +509,12 @@ CameraGraphicsItem* EditorTab::MakeCameraGraphicsItem(Camera* pCamera, int x, in
 
 void EditorTab::SyncPropertyEditor()
 {
+    if (mTransactionDepth > 0)
+    {
+        mPropertyEditorSyncPending = true;
+        return;
+    }
+
     auto selected = mScene->selectedItems();
     if (selected.count() == 1)
     {
@@ -464,6 +526,32 @@ void EditorTab::SyncPropertyEditor()
     }
 }
 
+void EditorTab::BeginTransaction(int itemCount)
+{
+    if (mTransactionDepth++ == 0)
+    {
+        mModel->BeginChanges();
+        mScene->BeginBulkEdit(itemCount);
+    }
+}
+
+void EditorTab::EndTransaction()
+{
+    if (--mTransactionDepth > 0)
+    {
+        return;
+    }
+
+    mScene->EndBulkEdit();
+    mModel->EndChanges();
+
+    if (mPropertyEditorSyncPending)
+    {
+        mPropertyEditorSyncPending = false;
+        SyncPropertyEditor();
+    }
+}
+
 void EditorTab::EditTransparency()
 {
     auto transparencyDialog = new TransparencyDialog(this, this);
@@ -494,7 +582,16 @@ void EditorTab::Paste(ClipBoard& clipBoard)
 {
     if (!clipBoard.IsEmpty())
     {
-        mUndoStack.push(new PasteItemsCommand(this, clipBoard));
+        // At the mouse if it's over the map, otherwise next to where the items were copied from
+        QGraphicsView* pView = ui->graphicsView;
+        const QPoint viewPos = pView->viewport()->mapFromGlobal(QCursor::pos());
+        std::optional<QPoint> scenePos;
+        if (pView->viewport()->rect().contains(viewPos))
+        {
+            scenePos = pView->mapToScene(viewPos).toPoint();
+        }
+
+        mUndoStack.push(new PasteItemsCommand(this, clipBoard, scenePos ? &*scenePos : nullptr));
         mStatusBar->showMessage(tr("Items pasted"), 2000);
     }
 }
@@ -571,6 +668,11 @@ void EditorTab::ResetZoom()
 EditorTab::~EditorTab()
 {
     disconnect(&mUndoStack, &QUndoStack::cleanChanged, this, &EditorTab::UpdateTabTitle);
+    disconnect(&mUndoStack, &QUndoStack::indexChanged, this, nullptr);
+    for (int token : mModelSubscriptions)
+    {
+        mModel->Unsubscribe(token);
+    }
     delete ui;
 }
 
@@ -585,7 +687,7 @@ void EditorTab::PopulatePropertyEditor(QGraphicsItem* pItem)
     ClearPropertyEditor();
 
     auto pTree = static_cast<PropertyTreeWidget*>(ui->treeWidget);
-    pTree->Populate(*mModel, mUndoStack, pItem);
+    pTree->Populate(mUndoStack, pItem);
 }
 
 void EditorTab::Undo()
@@ -606,86 +708,179 @@ bool EditorTab::Save()
     }
     else
     {
-        return DoSave(mJsonFileName);
+        return StartSave(mJsonFileName);
     }
 }
 
 bool EditorTab::SaveAs()
 {
-    QString jsonSaveFileName = QFileDialog::getSaveFileName(this, tr("Save " + mJsonFileName.toLocal8Bit() + " as json"), "", tr("Json Files (*.json);;All Files (*)"));
+#ifdef QT_EDITOR_GZIP
+    const QString filter = tr("Json Files (*.json);;Compressed Json Files (*.json.gz);;All Files (*)");
+#else
+    const QString filter = tr("Json Files (*.json);;All Files (*)");
+#endif
+    QString jsonSaveFileName = QFileDialog::getSaveFileName(this, tr("Save " + mJsonFileName.toLocal8Bit() + " as json"), "", filter);
     if (jsonSaveFileName.isEmpty())
     {
         // They didn't want to save it
         return false;
     }
 
-    // Append .json file ext if not specified
-    if (!jsonSaveFileName.endsWith(".json", Qt::CaseInsensitive))
+    // Append .json file ext if not specified, .json.gz saves compressed
+    if (!jsonSaveFileName.endsWith(".json", Qt::CaseInsensitive) && !jsonSaveFileName.endsWith(".json.gz", Qt::CaseInsensitive))
     {
         jsonSaveFileName += ".json";
     }
 
-    if (!DoSave(jsonSaveFileName))
+    return StartSave(jsonSaveFileName);
+}
+
+bool EditorTab::StartSave(QString fileName)
+{
+    // One at a time so they finish in order
+    FinishSave();
+
+    if (!IsJsonFileNameSupported(fileName.toStdString()))
     {
+        mSaveFailed = true;
+        QMessageBox::critical(this, "Error", kNoGzipSupportMessage);
         return false;
     }
 
-    // Saved OK, update the file name and tab title
-    mJsonFileName = jsonSaveFileName;
-
-    // No longer a temp file so don't force SaveAs next time
-    if (mIsTempFile)
+    auto pendingSave = std::make_unique<PendingSave>();
+    pendingSave->mFileName = fileName;
+    pendingSave->mUndoStackChanges = mUndoStackChanges;
+    pendingSave->mSnapshot = mModel->Snapshot();
+    if (mEditJournal)
     {
-        mIsTempFile = false;
-        UpdateCleanState();
-        UpdateTabTitle(true);
+        mEditJournal->Record(*mModel);
+        pendingSave->mJournalState = mEditJournal->RecordedState();
     }
 
+    mPendingSave = std::move(pendingSave);
+    mSaveFailed = false;
+    mStatusBar->showMessage(tr("Saving..."));
+
+    // The snapshot is kept alive by the task so the tab can even be closed while it runs. The cache is built from the
+    // same snapshot so it matches the saved json even if the model is edited before the save finishes.
+    mSaveWatcher.setFuture(QtConcurrent::run([pSnapshot = mPendingSave->mSnapshot, fileName, writeCache = mModelCacheEnabled]()
+        {
+            const std::optional<uint64_t> jsonHash = pSnapshot->SaveJsonToFile(fileName.toStdString());
+            if (jsonHash && writeCache)
+            {
+                SaveModelCache(*pSnapshot, *jsonHash, fileName);
+            }
+            return jsonHash;
+        }));
     return true;
 }
 
-template<class ResultType>
-static ResultType ExecASync(QString dialogTitle, std::function<ResultType()> fnDoWork)
+// QUndoStack can only mark the current index as clean. If there were edits while saving then no index matches the file
+// any more, not even the one that was clean before, so nothing is clean until the next save.
+static void MarkSaved(QUndoStack& undoStack, bool editedWhileSaving)
 {
-    auto dlg = new ProgressDialog();
-    dlg->setWindowFlags(Qt::Window | Qt::WindowTitleHint | Qt::CustomizeWindowHint);
-    dlg->setWindowTitle(dialogTitle);
+    if (editedWhileSaving)
+    {
+        undoStack.resetClean();
+    }
+    else
+    {
+        undoStack.setClean();
+    }
+}
 
-    QFutureWatcher<ResultType>* watcher = new QFutureWatcher<ResultType>();
-    QObject::connect(watcher, &QFutureWatcher<ResultType>::finished, [&]() { dlg->close(); });
-    QFuture<ResultType> f = QtConcurrent::run(fnDoWork);
+bool EditorTab::FinishSave()
+{
+    if (mPendingSave)
+    {
+        mSaveWatcher.waitForFinished();
+        SaveFinished();
+    }
+    return !mSaveFailed;
+}
 
-    watcher->setFuture(f);
+void EditorTab::SaveFinished()
+{
+    const std::unique_ptr<PendingSave> pendingSave = std::move(mPendingSave);
+    const std::optional<uint64_t> jsonHash = mSaveWatcher.result();
+    if (!jsonHash)
+    {
+        mSaveFailed = true;
+        QMessageBox::critical(this, "Error", "Failed to save " + pendingSave->mFileName);
+        mStatusBar->showMessage(tr("Save failed"));
+        return;
+    }
+
+    mModel->SetJsonFileHash(*jsonHash);
+    mJsonFileName = pendingSave->mFileName;
 
-    dlg->exec();
+    const bool editedWhileSaving = mUndoStackChanges != pendingSave->mUndoStackChanges;
+    MarkSaved(mUndoStack, editedWhileSaving);
+    mStatusBar->showMessage(tr("Saved"), 2000);
 
-    return f.result();
+    // No longer a temp file so don't force SaveAs next time
+    if (mIsTempFile)
+    {
+        mIsTempFile = false;
+        UpdateCleanState();
+        UpdateTabTitle(mUndoStack.isClean());
+    }
+
+    // Start again from the saved json, anything edited while saving goes in the first record
+    if (pendingSave->mJournalState)
+    {
+        mEditJournal.reset();
+        mEditJournal = std::make_unique<EditJournal>(mJsonFileName, *jsonHash, std::move(*pendingSave->mJournalState), *mModel);
+        if (mEditJournal->Owned())
+        {
+            emit EditJournalStarted(mJsonFileName);
+        }
+    }
+    else
+    {
+        ResetEditJournal(mJsonFileName, !editedWhileSaving);
+    }
 }
 
-bool EditorTab::DoSave(QString fileName)
+void EditorTab::WriteModelCache()
 {
-    if (ExecASync<bool>("Saving... " + fileName, [&]()
-        {
-            std::string json = mModel->ToJson();
-            QFile f(fileName);
-            if (f.open(QIODevice::WriteOnly))
+    if (mModelCacheEnabled && !mIsTempFile && mModel->JsonFileHash())
+    {
+        // Only the snapshot is taken here, the cache is built from it and written in the background
+        QtConcurrent::run([pSnapshot = mModel->Snapshot(), jsonHash = *mModel->JsonFileHash(), jsonFileName = mJsonFileName]()
             {
-                QTextStream stream(&f);
-                stream << json.c_str();
-                return true;
-            }
-            return false;
-        }))
+                SaveModelCache(*pSnapshot, jsonHash, jsonFileName);
+            });
+    }
+}
+
+void EditorTab::StartEditJournal(bool restoredEdits)
+{
+    if (mIsTempFile)
     {
-        mUndoStack.setClean();
-        mStatusBar->showMessage(tr("Saved"), 2000);
-        return true;
+        // Starts when it gets saved somewhere
+        return;
     }
-    else
+
+    ResetEditJournal(mJsonFileName, !restoredEdits);
+    if (restoredEdits)
     {
-        QMessageBox::critical(this, "Error", "Failed to save " + fileName);
-        mStatusBar->showMessage(tr("Save failed"));
-        return false;
+        mUndoStack.resetClean();
+    }
+}
+
+void EditorTab::ResetEditJournal(const QString& jsonFileName, bool modelMatchesJson)
+{
+    // Deletes the old journal before the new one can write to the same file
+    mEditJournal.reset();
+
+    if (mModel->JsonFileHash())
+    {
+        mEditJournal = std::make_unique<EditJournal>(jsonFileName, *mModel, modelMatchesJson);
+        if (mEditJournal->Owned())
+        {
+            emit EditJournalStarted(jsonFileName);
+        }
     }
 }
 
@@ -695,6 +890,7 @@ void EditorTab::Export(bool exportAndPlay)
     {
         Save();
     }
+    FinishSave();
 
     auto exportDialog = new ExportPathDialog(this, exportAndPlay);
     exportDialog->setJsonPath(mJsonFileName);
@@ -829,7 +1025,7 @@ public:
     void redo() override
     {
         mTab->GetScene().addItem(mArrowItem);
-        mTab->GetModel().CollisionItems().push_back(std::move(mNewObject));
+        mTab->GetModel().AddCollisionItem(std::move(mNewObject));
 
         // Set the new item as the only thing selected
         mTab->GetScene().clearSelection();
@@ -843,21 +1039,10 @@ public:
 private:
     void MakeNewCollision()
     {
-        mNewObject = std::make_unique<CollisionObject>(mTab->GetModel().NextCollisionId());
-        // TODO: Duplicated with AddNewObjectCommand::MakeNewObject
-        for (auto& prop : mTab->GetModel().CollisionStructure().mEnumAndBasicTypeProperties)
-        {
-            auto foundType = mTab->GetModel().FindType(prop.mType);
-
-            auto newProp = mTab->GetModel().MakeProperty(foundType, prop, &mTab->GetModel().CollisionStructure());
-            if (foundType.mEnum)
-            {
-                auto enumType = mTab->GetModel().FindEnum(prop.mType);
-                newProp->mEnumValue = enumType->mValues[0];
-            }
-
-            mNewObject->mProperties.emplace_back(std::move(newProp));
-        }
+        ModelArena* pArena = mTab->GetModel().Arena().get();
+        mNewObject = MakeInArena<CollisionObject>(pArena, pArena, mTab->GetModel().NextCollisionId());
+        mNewObject->mStructure = mTab->GetModel().CollisionStructure();
+        mNewObject->mProperties = mTab->GetModel().DefaultProperties(*mNewObject->mStructure);
 
         QGraphicsView* pView = mTab->GetScene().views().at(0);
         QPoint scenePos = pView->mapToScene(pView->pos()).toPoint();
@@ -897,7 +1082,7 @@ void EditorTab::ConnectCollisions()
             }
         }
 
-        std::vector<CollisionConnectData> collisionConnectData = CollisionConnectCommand::getConnectCollisionsChanges(collisions);
+        std::vector<CollisionConnectData> collisionConnectData = CollisionConnectCommand::getConnectCollisionsChanges(*mModel, collisions);
 
         if (!collisionConnectData.empty())
         {
@@ -933,3 +1118,48 @@ int EditorTab::SnapY(bool enabled, int y)
     }
     return y;
 }
+
+void Test_SaveWithPendingEdit()
+{
+    QUndoStack undoStack;
+    for (int i = 0; i < 3; i++)
+    {
+        undoStack.push(new QUndoCommand());
+    }
+    undoStack.setClean();
+
+    // Saved at 5 and edited again before the save finished
+    undoStack.push(new QUndoCommand());
+    undoStack.push(new QUndoCommand());
+    undoStack.push(new QUndoCommand());
+    MarkSaved(undoStack, true);
+
+    for (int index = 6; index >= 0; index--)
+    {
+        undoStack.setIndex(index);
+        if (undoStack.isClean())
+        {
+            abort();
+        }
+    }
+}
+
+void Test_SaveWithoutPendingEdit()
+{
+    QUndoStack undoStack;
+    undoStack.push(new QUndoCommand());
+    undoStack.setClean();
+    undoStack.push(new QUndoCommand());
+    MarkSaved(undoStack, false);
+
+    if (!undoStack.isClean() || undoStack.cleanIndex() != 2)
+    {
+        abort();
+    }
+}
+
+void DoEditorTabTests()
+{
+    Test_SaveWithPendingEdit();
+    Test_SaveWithoutPendingEdit();
+}
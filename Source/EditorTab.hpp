@@ -8,6 +8,7 @@
 #include <QPainter>
 #include <QTreeWidget>
 #include <QApplication>
+#include <QFutureWatcher>
 #include <memory>
 #include "Model.hpp"
 #include "SnapSettings.hpp"
@@ -26,6 +27,7 @@ class CollisionObject;
 class CameraManager;
 class ClipBoard;
 class SnapSettings;
+class EditJournal;
 
 class EditorTab final : public QMainWindow, public IPointSnapper
 {
@@ -36,8 +38,14 @@ public:
     void ZoomIn();
     void ZoomOut();
     void ResetZoom();
+
+    // Saving happens in the background from a snapshot of the model, these return false if it wasn't started
     bool Save();
     bool SaveAs();
+
+    // Waits for the save in progress if there is one, returns false if the last save failed
+    bool FinishSave();
+
     void Export(bool exportAndPlay);
     QString GetJsonFileName() const { return mJsonFileName; }
     Model& GetModel() const { return *mModel; }
@@ -78,6 +86,18 @@ public:
     ResizeableArrowItem* MakeResizeableArrowItem(CollisionObject* pCollisionObject);
     CameraGraphicsItem* MakeCameraGraphicsItem(Camera* pCamera, int x, int y, int w, int h);
 
+    void SetModelCacheEnabled(bool enabled)
+    {
+        mModelCacheEnabled = enabled;
+    }
+
+    // Writes the model to the cache file next to the json in the background, if enabled and the json is a real file
+    void WriteModelCache();
+
+    // Starts recording edits to a journal next to the json so they can be restored after a crash. If the model was
+    // restored from an old journal then it no longer matches the json and the tab starts out unsaved.
+    void StartEditJournal(bool restoredEdits);
+
     CameraManager* GetCameraManagerDialog()
     {
         return mCameraManager;
@@ -88,8 +108,15 @@ public:
         mCameraManager = pDlg;
     }
 
+    // Inside a transaction this waits for it to end, so it's done once however many items the edit touched
     void SyncPropertyEditor();
 
+    // Edits that touch many items run inside these, best through EditTransaction. Until the outermost one ends the
+    // model's changes are held back, syncing the property editor is put off and, if itemCount is large next to the
+    // scene, the scene stops keeping its index of items up to date to build it again once at the end.
+    void BeginTransaction(int itemCount);
+    void EndTransaction();
+
     void EditTransparency();
 
     void Cut(ClipBoard& clipBoard);
@@ -98,20 +125,31 @@ public:
 
 signals:
     void CleanChanged();
+    void EditJournalStarted(QString jsonFileName);
 
 private slots:
 
     void cleanChanged(bool clean);
 
 private:
-    bool DoSave(QString fileName);
+    struct PendingSave;
+    bool StartSave(QString fileName);
+    void SaveFinished();
+    void ResetEditJournal(const QString& jsonFileName, bool modelMatchesJson);
 
     int SnapX(bool enabled, int x) override;
     int SnapY(bool enabled, int y) override;
 
     Ui::EditorTab* ui = nullptr;
     float iZoomLevel = 1.0f;
+
+    // Kept by the tab as well so that nothing the undo stack or scene still holds outlives what it was allocated from
+    SP_ModelArena mArena;
     UP_Model mModel;
+
+    // Tokens from mModel->Subscribe(), unsubscribed when the tab is destroyed
+    std::vector<int> mModelSubscriptions;
+
     QUndoStack mUndoStack;
     std::unique_ptr<EditorGraphicsScene> mScene;
     QString mJsonFileName;
@@ -121,10 +159,42 @@ private:
     QString mExtraLvlsPath;
     QTabWidget* mParent = nullptr;
     bool mIsTempFile = false;
+    bool mModelCacheEnabled = false;
+    std::unique_ptr<EditJournal> mEditJournal;
+
+    // Counts pushes, undos and redos so a save can tell if anything was edited while it ran
+    uint64_t mUndoStackChanges = 0;
+    QFutureWatcher<std::optional<uint64_t>> mSaveWatcher;
+    std::unique_ptr<PendingSave> mPendingSave;
+    bool mSaveFailed = false;
 
     CameraManager* mCameraManager = nullptr;
 
+    int mTransactionDepth = 0;
+    bool mPropertyEditorSyncPending = false;
+
     QStatusBar* mStatusBar = nullptr;
 
     SnapSettings& mSnapSettings;
 };
+
+// Runs an edit, such as an undo command's redo() or undo(), as a transaction of the tab for as long as it's in scope
+class EditTransaction final
+{
+public:
+    EditTransaction(EditorTab* pTab, int itemCount) : mTab(pTab)
+    {
+        mTab->BeginTransaction(itemCount);
+    }
+
+    ~EditTransaction()
+    {
+        mTab->EndTransaction();
+    }
+
+    EditTransaction(const EditTransaction&) = delete;
+    EditTransaction& operator=(const EditTransaction&) = delete;
+
+private:
+    EditorTab* mTab = nullptr;
+};
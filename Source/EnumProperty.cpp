@@ -6,24 +6,22 @@
 ChangeEnumPropertyCommand::ChangeEnumPropertyCommand(LinkedProperty linkedProperty, EnumPropertyChangeData propertyData)
     : mLinkedProperty(linkedProperty), mPropertyData(propertyData)
 {
-    setText(QString("Change property %1 from %2 to %3").arg(mLinkedProperty.mProperty->mName.c_str(), mPropertyData.mEnum->mValues[mPropertyData.mOldIdx].c_str(), mPropertyData.mEnum->mValues[mPropertyData.mNewIdx].c_str()));
+    setText(QString("Change property %1 from %2 to %3").arg(mLinkedProperty.mProperty->Name().c_str(), mPropertyData.mEnum->mValues[mPropertyData.mOldIdx].c_str(), mPropertyData.mEnum->mValues[mPropertyData.mNewIdx].c_str()));
 }
 
 void ChangeEnumPropertyCommand::undo()
 {
-    mLinkedProperty.mProperty->mEnumValue = mPropertyData.mEnum->mValues[mPropertyData.mOldIdx];
-    mLinkedProperty.mTreeWidget->FindObjectPropertyByKey(mLinkedProperty.mProperty)->Refresh();
-    mLinkedProperty.mGraphicsItem->SyncInternalObject();
+    mLinkedProperty.mProperty->mEnumValueIndex = mPropertyData.mOldIdx;
+    mLinkedProperty.mGraphicsItem->MarkInternalObjectDirty();
 }
 
 void ChangeEnumPropertyCommand::redo()
 {
-    mLinkedProperty.mProperty->mEnumValue = mPropertyData.mEnum->mValues[mPropertyData.mNewIdx];
-    mLinkedProperty.mTreeWidget->FindObjectPropertyByKey(mLinkedProperty.mProperty)->Refresh();
-    mLinkedProperty.mGraphicsItem->SyncInternalObject();
+    mLinkedProperty.mProperty->mEnumValueIndex = mPropertyData.mNewIdx;
+    mLinkedProperty.mGraphicsItem->MarkInternalObjectDirty();
 }
 
-EnumProperty::EnumProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem, Enum* pEnum) : PropertyTreeItemBase(pParent, QStringList{ kIndent + pProperty->mName.c_str(), pProperty->mEnumValue.c_str() }), mUndoStack(undoStack), mProperty(pProperty), mGraphicsItem(pGraphicsItem), mEnum(pEnum)
+EnumProperty::EnumProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem) : PropertyTreeItemBase(pParent, QStringList{ kIndent + pProperty->Name().c_str(), pProperty->EnumValue().c_str() }), mUndoStack(undoStack), mProperty(pProperty), mGraphicsItem(pGraphicsItem), mEnum(&pProperty->GetEnum())
 {
 
 }
@@ -35,20 +33,14 @@ QWidget* EnumProperty::CreateEditorWidget(PropertyTreeWidget* pParent)
     {
         mCombo->addItem(item.c_str());
     }
-    SetPropertyIndexFromEnumValue();
     Refresh();
 
-    if (mOldIdx != -1)
-    {
-        mCombo->setCurrentIndex(mOldIdx);
-    }
-
-    connect(mCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [pParent, this](int index)
+    connect(mCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index)
         {
             if (index != -1 && mOldIdx != index)
             {
                 mUndoStack.push(new ChangeEnumPropertyCommand(
-                    LinkedProperty(pParent, this->mProperty, this->mGraphicsItem),
+                    LinkedProperty(this->mProperty, this->mGraphicsItem),
                     EnumPropertyChangeData(this->mEnum, this->mOldIdx, index)));
             }
             mOldIdx = index;
@@ -63,8 +55,7 @@ QWidget* EnumProperty::CreateEditorWidget(PropertyTreeWidget* pParent)
 
 void EnumProperty::Refresh()
 {
-    // Update the idx based on the enum value
-    SetPropertyIndexFromEnumValue();
+    mOldIdx = mProperty->mEnumValueIndex;
 
     // Update the text to match the enum value via its index
     setText(1, mEnum->mValues[mOldIdx].c_str());
@@ -75,18 +66,3 @@ void EnumProperty::Refresh()
         mCombo->setCurrentIndex(mOldIdx);
     }
 }
-
-void EnumProperty::SetPropertyIndexFromEnumValue()
-{
-    mOldIdx = -1;
-    int i = 0;
-    for (auto& item : mEnum->mValues)
-    {
-        if (mProperty->mEnumValue == item.c_str())
-        {
-            mOldIdx = i;
-            break;
-        }
-        i++;
-    }
-}
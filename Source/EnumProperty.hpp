@@ -9,12 +9,12 @@ class QUndoStack;
 
 struct EnumPropertyChangeData
 {
-    EnumPropertyChangeData(Enum* pEnum, int oldIdx, int newIdx)
+    EnumPropertyChangeData(const Enum* pEnum, int oldIdx, int newIdx)
         : mEnum(pEnum), mOldIdx(oldIdx), mNewIdx(newIdx)
     {
 
     }
-    Enum* mEnum = nullptr;
+    const Enum* mEnum = nullptr;
     int mOldIdx = 0;
     int mNewIdx = 0;
 };
@@ -37,25 +37,17 @@ class EnumProperty final : public QObject, public PropertyTreeItemBase
 {
     Q_OBJECT
 public:
-    EnumProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem, Enum* pEnum);
+    EnumProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem);
 
     QWidget* CreateEditorWidget(PropertyTreeWidget* pParent) override;
 
     void Refresh() override;
 
-    const void* GetPropertyLookUpKey() const override
-    {
-        return mProperty;
-    }
-
-
 private:
-    void SetPropertyIndexFromEnumValue();
-
     QUndoStack& mUndoStack;
     ObjectProperty* mProperty = nullptr;
     IGraphicsItem* mGraphicsItem = nullptr;
-    Enum* mEnum = nullptr;
+    const Enum* mEnum = nullptr;
     int mOldIdx = -1;
 
     QComboBox* mCombo = nullptr;
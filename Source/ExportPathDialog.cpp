@@ -33,7 +33,12 @@ ExportPathDialog::~ExportPathDialog()
 
 void ExportPathDialog::on_btnSelectJson_clicked()
 {
-    QString jsonFileName = QFileDialog::getOpenFileName(this, tr("Save path json"), "", tr("Json Files (*.json);;All Files (*)"));
+#ifdef QT_EDITOR_GZIP
+    const QString filter = tr("Json Files (*.json *.json.gz);;All Files (*)");
+#else
+    const QString filter = tr("Json Files (*.json);;All Files (*)");
+#endif
+    QString jsonFileName = QFileDialog::getOpenFileName(this, tr("Save path json"), "", filter);
     if (!jsonFileName.isEmpty())
     {
         setJsonPath(jsonFileName);
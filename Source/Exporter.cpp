@@ -6,6 +6,12 @@
 
 bool exportJsonToLvl(QString jsonPath, QString lvlPath, QString partialTemporaryFilePath, std::function<void(const QString)> onFailure, std::set<std::string>& resourceSources, ReliveAPI::Context& context)
 {
+    if (!IsJsonFileNameSupported(jsonPath.toStdString()))
+    {
+        onFailure(kNoGzipSupportMessage);
+        return false;
+    }
+
     EditorFileIO fileIo;
     auto fnExport = [&]()
     {
@@ -8,7 +8,11 @@ class IGraphicsItem
 public:
     virtual ~IGraphicsItem() { }
     virtual void SyncInternalObject() = 0;
-    virtual std::vector<UP_ObjectProperty>& GetProperties() = 0;
+
+    // Call after editing the model object directly so the next save formats it again, and so the model tells the
+    // scene and property editor to show the change
+    virtual void MarkInternalObjectDirty() = 0;
+    virtual ObjectProperties& GetProperties() = 0;
 
     static void SetTransparency(QGraphicsItem* pItem, int transparency)
     {
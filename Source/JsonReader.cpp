@@ -0,0 +1,665 @@
+#include "JsonReader.hpp"
+#include "JsonWriter.hpp"
+#include "Model.hpp"
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+static const char* SkipWhiteSpace(const char* p, const char* pEnd)
+{
+    while (p != pEnd && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+    {
+        p++;
+    }
+    return p;
+}
+
+// p is the opening quote, returns one past the closing quote
+static const char* SkipString(const char* p, const char* pEnd)
+{
+    p++;
+    for (;;)
+    {
+        // Strings can be huge (base64 camera images) so let memchr do the searching
+        const char* pQuote = static_cast<const char*>(std::memchr(p, '"', pEnd - p));
+        if (!pQuote)
+        {
+            throw InvalidJsonException();
+        }
+
+        // The quote is escaped if its preceded by an odd number of back slashes
+        const char* pSlash = pQuote;
+        while (pSlash != p && *(pSlash - 1) == '\\')
+        {
+            pSlash--;
+        }
+
+        if ((pQuote - pSlash) % 2 == 0)
+        {
+            return pQuote + 1;
+        }
+        p = pQuote + 1;
+    }
+}
+
+// p is the opening bracket, returns one past the matching closing bracket
+static const char* SkipContainer(const char* p, const char* pEnd)
+{
+    // The closing bracket each open container needs, a path is rarely more than a few deep so this stays in the
+    // string's own buffer
+    std::string closers;
+    while (p != pEnd)
+    {
+        switch (*p)
+        {
+        case '"':
+            p = SkipString(p, pEnd);
+            continue;
+
+        case '{':
+            closers += '}';
+            break;
+
+        case '[':
+            closers += ']';
+            break;
+
+        case '}':
+        case ']':
+            if (closers.back() != *p)
+            {
+                throw InvalidJsonException();
+            }
+            closers.pop_back();
+            if (closers.empty())
+            {
+                return p + 1;
+            }
+            break;
+        }
+        p++;
+    }
+    throw InvalidJsonException();
+}
+
+static const char* SkipLiteral(const char* p, const char* pEnd, std::string_view literal)
+{
+    if (static_cast<size_t>(pEnd - p) < literal.size() || std::string_view(p, literal.size()) != literal)
+    {
+        throw InvalidJsonException();
+    }
+    return p + literal.size();
+}
+
+// Reads the extent of the value starting at p and moves p past it
+static JsonValue ReadValue(const char*& p, const char* pEnd)
+{
+    p = SkipWhiteSpace(p, pEnd);
+    if (p == pEnd)
+    {
+        throw InvalidJsonException();
+    }
+
+    const char* pStart = p;
+    JsonValue::Type type = JsonValue::Type::Null;
+    switch (*p)
+    {
+    case '"':
+        type = JsonValue::Type::String;
+        p = SkipString(p, pEnd);
+        break;
+
+    case '{':
+        type = JsonValue::Type::Object;
+        p = SkipContainer(p, pEnd);
+        break;
+
+    case '[':
+        type = JsonValue::Type::Array;
+        p = SkipContainer(p, pEnd);
+        break;
+
+    case 't':
+        type = JsonValue::Type::Boolean;
+        p = SkipLiteral(p, pEnd, "true");
+        break;
+
+    case 'f':
+        type = JsonValue::Type::Boolean;
+        p = SkipLiteral(p, pEnd, "false");
+        break;
+
+    case 'n':
+        type = JsonValue::Type::Null;
+        p = SkipLiteral(p, pEnd, "null");
+        break;
+
+    default:
+        type = JsonValue::Type::Number;
+        while (p != pEnd && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+        {
+            p++;
+        }
+
+        if (p == pStart)
+        {
+            throw InvalidJsonException();
+        }
+        break;
+    }
+    return JsonValue(type, std::string_view(pStart, p - pStart));
+}
+
+static unsigned int ReadHex4(const char*& p, const char* pEnd)
+{
+    if (pEnd - p < 4)
+    {
+        throw InvalidJsonException();
+    }
+
+    unsigned int value = 0;
+    for (int i = 0; i < 4; i++, p++)
+    {
+        value <<= 4;
+        if (*p >= '0' && *p <= '9')
+        {
+            value |= *p - '0';
+        }
+        else if (*p >= 'a' && *p <= 'f')
+        {
+            value |= *p - 'a' + 10;
+        }
+        else if (*p >= 'A' && *p <= 'F')
+        {
+            value |= *p - 'A' + 10;
+        }
+        else
+        {
+            throw InvalidJsonException();
+        }
+    }
+    return value;
+}
+
+static void AppendUtf8(std::string& out, unsigned int codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        out += static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+// raw is the string contents without the quotes
+static std::string Unescape(std::string_view raw)
+{
+    std::string out;
+    out.reserve(raw.size());
+
+    const char* p = raw.data();
+    const char* pEnd = p + raw.size();
+    while (p != pEnd)
+    {
+        const char* pSlash = static_cast<const char*>(std::memchr(p, '\\', pEnd - p));
+        if (!pSlash)
+        {
+            out.append(p, pEnd);
+            break;
+        }
+
+        out.append(p, pSlash);
+        p = pSlash + 1;
+        if (p == pEnd)
+        {
+            throw InvalidJsonException();
+        }
+
+        const char escaped = *p++;
+        switch (escaped)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out += escaped;
+            break;
+
+        case 'b':
+            out += '\b';
+            break;
+
+        case 'f':
+            out += '\f';
+            break;
+
+        case 'n':
+            out += '\n';
+            break;
+
+        case 'r':
+            out += '\r';
+            break;
+
+        case 't':
+            out += '\t';
+            break;
+
+        case 'u':
+        {
+            unsigned int codePoint = ReadHex4(p, pEnd);
+            if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+            {
+                // Low half of a surrogate pair without the high half
+                throw InvalidJsonException();
+            }
+
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+            {
+                // Surrogate pair, the low half has to follow straight away
+                if (pEnd - p < 6 || p[0] != '\\' || p[1] != 'u')
+                {
+                    throw InvalidJsonException();
+                }
+                p += 2;
+                const unsigned int low = ReadHex4(p, pEnd);
+                if (low < 0xDC00 || low > 0xDFFF)
+                {
+                    throw InvalidJsonException();
+                }
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            AppendUtf8(out, codePoint);
+            break;
+        }
+
+        default:
+            throw InvalidJsonException();
+        }
+    }
+    return out;
+}
+
+int JsonValue::ToInt() const
+{
+    const char* p = mText.data();
+    const char* pEnd = p + mText.size();
+
+    const bool negative = p != pEnd && *p == '-';
+    if (negative)
+    {
+        p++;
+    }
+
+    // Plain integers are by far the most common so parse them directly
+    const char* pDigits = p;
+    long long value = 0;
+    while (p != pEnd && *p >= '0' && *p <= '9' && p - pDigits < 18)
+    {
+        value = (value * 10) + (*p - '0');
+        p++;
+    }
+
+    if (p == pEnd && p != pDigits)
+    {
+        if (negative)
+        {
+            value = -value;
+        }
+
+        if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max())
+        {
+            throw InvalidJsonException();
+        }
+        return static_cast<int>(value);
+    }
+
+    // Fractions or exponents get truncated just like they always have been
+    std::istringstream stream{ std::string(mText) };
+    stream.imbue(std::locale::classic());
+    double number = 0.0;
+    if (!(stream >> number))
+    {
+        throw InvalidJsonException();
+    }
+
+    // Also false for NaN
+    if (!(number > std::numeric_limits<int>::min() - 1.0 && number < std::numeric_limits<int>::max() + 1.0))
+    {
+        throw InvalidJsonException();
+    }
+    return static_cast<int>(number);
+}
+
+bool JsonValue::ToBool() const
+{
+    return mText == "true";
+}
+
+std::string JsonValue::ToString() const
+{
+    const std::string_view raw = mText.substr(1, mText.size() - 2);
+    if (raw.find('\\') == std::string_view::npos)
+    {
+        return std::string(raw);
+    }
+    return Unescape(raw);
+}
+
+JsonObject::JsonObject(const JsonValue& value)
+{
+    const std::string_view text = value.Text();
+    if (value.GetType() != JsonValue::Type::Object)
+    {
+        throw InvalidJsonException();
+    }
+
+    // Skip the braces
+    const char* p = SkipWhiteSpace(text.data() + 1, text.data() + text.size() - 1);
+    const char* pEnd = text.data() + text.size() - 1;
+    while (p != pEnd)
+    {
+        if (*p != '"')
+        {
+            throw InvalidJsonException();
+        }
+
+        const char* pKeyStart = p;
+        p = SkipString(p, pEnd);
+        std::string_view key(pKeyStart + 1, p - pKeyStart - 2);
+        if (key.find('\\') != std::string_view::npos)
+        {
+            mUnescapedKeys.push_back(Unescape(key));
+            key = mUnescapedKeys.back();
+        }
+
+        p = SkipWhiteSpace(p, pEnd);
+        if (p == pEnd || *p != ':')
+        {
+            throw InvalidJsonException();
+        }
+        p++;
+
+        mMembers.emplace_back(key, ReadValue(p, pEnd));
+
+        p = SkipWhiteSpace(p, pEnd);
+        if (p != pEnd)
+        {
+            if (*p != ',')
+            {
+                throw InvalidJsonException();
+            }
+
+            p = SkipWhiteSpace(p + 1, pEnd);
+            if (p == pEnd)
+            {
+                throw InvalidJsonException();
+            }
+        }
+    }
+}
+
+const JsonValue* JsonObject::Find(std::string_view key) const
+{
+    // The last of any duplicate keys wins, as it did with jsonxx
+    for (auto it = mMembers.rbegin(); it != mMembers.rend(); ++it)
+    {
+        if (it->first == key)
+        {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+JsonArray::JsonArray(const JsonValue& value)
+{
+    const std::string_view text = value.Text();
+    if (value.GetType() != JsonValue::Type::Array)
+    {
+        throw InvalidJsonException();
+    }
+
+    const char* p = SkipWhiteSpace(text.data() + 1, text.data() + text.size() - 1);
+    const char* pEnd = text.data() + text.size() - 1;
+    while (p != pEnd)
+    {
+        mElements.push_back(ReadValue(p, pEnd));
+
+        p = SkipWhiteSpace(p, pEnd);
+        if (p != pEnd)
+        {
+            if (*p != ',')
+            {
+                throw InvalidJsonException();
+            }
+
+            p = SkipWhiteSpace(p + 1, pEnd);
+            if (p == pEnd)
+            {
+                throw InvalidJsonException();
+            }
+        }
+    }
+}
+
+JsonValue ParseJsonDocument(std::string_view json)
+{
+    const char* p = json.data();
+    const char* pEnd = p + json.size();
+    JsonValue root = ReadValue(p, pEnd);
+    if (SkipWhiteSpace(p, pEnd) != pEnd)
+    {
+        throw InvalidJsonException();
+    }
+    return root;
+}
+
+struct TestJsonDocument final
+{
+    std::string mName;
+    std::vector<int> mInts;
+    std::vector<std::string> mStrings;
+};
+
+static std::string WriteTestJson(const TestJsonDocument& document)
+{
+    StringJsonSink sink;
+    JsonWriter writer(sink);
+    writer.BeginObject();
+    writer.Key("name");
+    writer.String(document.mName);
+    writer.Key("ints");
+    writer.BeginArray();
+    for (int value : document.mInts)
+    {
+        writer.Int(value);
+    }
+    writer.EndArray();
+    writer.Key("nested");
+    writer.BeginObject();
+    writer.Key("strings");
+    writer.BeginArray();
+    for (const std::string& value : document.mStrings)
+    {
+        writer.String(value);
+    }
+    writer.EndArray();
+    writer.Key("empty");
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndObject();
+    writer.EndObject();
+    return std::move(sink.String());
+}
+
+static TestJsonDocument ReadTestJson(const std::string& json)
+{
+    const JsonObject root(ParseJsonDocument(json));
+    const JsonObject nested(*root.Find("nested"));
+    if (!root.Has("name", JsonValue::Type::String) ||
+        !root.Has("ints", JsonValue::Type::Array) ||
+        !nested.Has("strings", JsonValue::Type::Array) ||
+        !nested.Has("empty", JsonValue::Type::Array) ||
+        JsonArray(*nested.Find("empty")).size() != 0)
+    {
+        abort();
+    }
+
+    TestJsonDocument document;
+    document.mName = root.Find("name")->ToString();
+    for (const JsonValue& value : JsonArray(*root.Find("ints")))
+    {
+        document.mInts.push_back(value.ToInt());
+    }
+    for (const JsonValue& value : JsonArray(*nested.Find("strings")))
+    {
+        document.mStrings.push_back(value.ToString());
+    }
+    return document;
+}
+
+static bool IsInvalidJsonString(std::string_view quoted)
+{
+    try
+    {
+        ParseJsonDocument(quoted).ToString();
+    }
+    catch (const InvalidJsonException&)
+    {
+        return true;
+    }
+    return false;
+}
+
+static bool IsInvalidJsonInt(std::string_view number)
+{
+    try
+    {
+        ParseJsonDocument(number).ToInt();
+    }
+    catch (const InvalidJsonException&)
+    {
+        return true;
+    }
+    return false;
+}
+
+static bool IsInvalidJsonDocument(std::string_view json)
+{
+    try
+    {
+        ParseJsonDocument(json);
+    }
+    catch (const InvalidJsonException&)
+    {
+        return true;
+    }
+    return false;
+}
+
+void Test_JsonRoundTrip()
+{
+    TestJsonDocument document;
+    document.mName = "plain";
+    document.mInts = { 0, -1, 42, 2147483647, -2147483647 - 1 };
+    document.mStrings =
+    {
+        "",
+        "\"quoted\" back\\slash /",
+        "\b\f\n\r\t\x01\x1f",
+        "caf\xc3\xa9 \xf0\x9f\x98\x80",
+        std::string(5000, 'A'),
+    };
+
+    // Load what was saved, save it again and it must come out the same
+    const std::string json = WriteTestJson(document);
+    const TestJsonDocument loaded = ReadTestJson(json);
+    if (loaded.mName != document.mName || loaded.mInts != document.mInts || loaded.mStrings != document.mStrings ||
+        WriteTestJson(loaded) != json)
+    {
+        abort();
+    }
+}
+
+void Test_JsonDuplicateKeys()
+{
+    const JsonObject root(ParseJsonDocument("{ \"x\": 1, \"y\": 2, \"x\": 3 }"));
+    if (root.Find("x")->ToInt() != 3 || root.Find("y")->ToInt() != 2 || root.Find("z"))
+    {
+        abort();
+    }
+}
+
+void Test_JsonSurrogates()
+{
+    if (ParseJsonDocument("\"\\ud83d\\ude00\\u00e9\"").ToString() != "\xf0\x9f\x98\x80\xc3\xa9")
+    {
+        abort();
+    }
+
+    if (!IsInvalidJsonString("\"\\ud83dX\"") ||
+        !IsInvalidJsonString("\"\\ud83d\"") ||
+        !IsInvalidJsonString("\"\\ud83d\\u0041\"") ||
+        !IsInvalidJsonString("\"\\ude00\""))
+    {
+        abort();
+    }
+}
+
+void Test_JsonBrackets()
+{
+    // Containers that are only skipped over still have to close with the right brackets
+    if (!IsInvalidJsonDocument("{\"a\":[1}]") ||
+        !IsInvalidJsonDocument("[{]}") ||
+        !IsInvalidJsonDocument("{\"a\":{\"b\":[]}") ||
+        IsInvalidJsonDocument("{\"a\":[{\"b\":\"]}\"}],\"c\":{}}"))
+    {
+        abort();
+    }
+}
+
+void Test_JsonIntRange()
+{
+    if (ParseJsonDocument("-2147483648").ToInt() != -2147483647 - 1 ||
+        ParseJsonDocument("2147483647").ToInt() != 2147483647 ||
+        ParseJsonDocument("12.75").ToInt() != 12 ||
+        ParseJsonDocument("-1e3").ToInt() != -1000)
+    {
+        abort();
+    }
+
+    if (!IsInvalidJsonInt("2147483648") ||
+        !IsInvalidJsonInt("-2147483649") ||
+        !IsInvalidJsonInt("99999999999999999999") ||
+        !IsInvalidJsonInt("1e10") ||
+        !IsInvalidJsonInt("-3e9"))
+    {
+        abort();
+    }
+}
+
+void DoJsonTests()
+{
+    Test_JsonRoundTrip();
+    Test_JsonDuplicateKeys();
+    Test_JsonSurrogates();
+    Test_JsonBrackets();
+    Test_JsonIntRange();
+}
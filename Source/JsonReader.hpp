@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+
+// A light weight json reader used to load path files. Instead of building a DOM every container is scanned
+// once to find where each of its members start and end in the source text. Values are only decoded when they
+// are read, so numbers go straight to ints and strings are unescaped once into the std::string that ends up
+// being moved into the model. The source text must out live any JsonValue/JsonObject/JsonArray viewing it.
+
+class JsonValue final
+{
+public:
+    enum class Type
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    JsonValue() = default;
+
+    JsonValue(Type type, std::string_view text)
+        : mType(type), mText(text)
+    {
+
+    }
+
+    Type GetType() const { return mType; }
+
+    // The source text of the value including quotes/brackets
+    std::string_view Text() const { return mText; }
+
+    int ToInt() const;
+    bool ToBool() const;
+    std::string ToString() const;
+
+private:
+    Type mType = Type::Null;
+    std::string_view mText;
+};
+
+class JsonObject final
+{
+public:
+    explicit JsonObject(const JsonValue& value);
+    JsonObject(JsonObject&&) = default;
+    JsonObject(const JsonObject&) = delete;
+
+    const JsonValue* Find(std::string_view key) const;
+
+    bool Has(std::string_view key, JsonValue::Type type) const
+    {
+        const JsonValue* pValue = Find(key);
+        return pValue && pValue->GetType() == type;
+    }
+
+private:
+    std::vector<std::pair<std::string_view, JsonValue>> mMembers;
+
+    // Storage for the rare keys that contained escapes and so can't be viewed directly
+    std::deque<std::string> mUnescapedKeys;
+};
+
+class JsonArray final
+{
+public:
+    explicit JsonArray(const JsonValue& value);
+
+    size_t size() const { return mElements.size(); }
+    const JsonValue& operator[](size_t idx) const { return mElements[idx]; }
+
+    std::vector<JsonValue>::const_iterator begin() const { return mElements.begin(); }
+    std::vector<JsonValue>::const_iterator end() const { return mElements.end(); }
+
+private:
+    std::vector<JsonValue> mElements;
+};
+
+// Finds the top level value of a json document, throws InvalidJsonException if there isn't exactly one
+JsonValue ParseJsonDocument(std::string_view json);
@@ -0,0 +1,233 @@
+#include "JsonWriter.hpp"
+#include "ReliveApiWrapper.hpp"
+#include <cstring>
+#include <algorithm>
+
+constexpr size_t kFileSinkBufferSize = 1024 * 1024;
+
+FileJsonSink::FileJsonSink(ReliveAPI::IFile& file)
+    : mFile(file)
+{
+    mBuffer.resize(kFileSinkBufferSize);
+}
+
+void FileJsonSink::Write(std::string_view data)
+{
+    if (mUsed + data.size() > mBuffer.size())
+    {
+        Flush();
+    }
+
+    if (data.size() >= mBuffer.size())
+    {
+        WriteToFile(data);
+        return;
+    }
+
+    std::memcpy(mBuffer.data() + mUsed, data.data(), data.size());
+    mUsed += data.size();
+}
+
+bool FileJsonSink::Flush()
+{
+    if (mUsed > 0)
+    {
+        WriteToFile(std::string_view(mBuffer.data(), mUsed));
+        mUsed = 0;
+    }
+    return mOk;
+}
+
+void FileJsonSink::WriteToFile(std::string_view data)
+{
+    mHasher.Update(data);
+    mOk &= mFile.Write(reinterpret_cast<const u8*>(data.data()), data.size());
+}
+
+JsonWriter::JsonWriter(IJsonSink& sink)
+    : mSink(sink)
+{
+
+}
+
+JsonWriter::JsonWriter(IJsonSink& sink, size_t depth)
+    : mSink(sink), mHasMembers(depth, false)
+{
+
+}
+
+void JsonWriter::BeginObject()
+{
+    BeginValue();
+    mSink.Write("{");
+    mHasMembers.push_back(false);
+}
+
+void JsonWriter::EndObject()
+{
+    EndContainer('}');
+}
+
+void JsonWriter::BeginArray()
+{
+    BeginValue();
+    mSink.Write("[");
+    mHasMembers.push_back(false);
+}
+
+void JsonWriter::EndArray()
+{
+    EndContainer(']');
+}
+
+void JsonWriter::Key(std::string_view key)
+{
+    NewMember();
+    WriteQuoted(key);
+    mSink.Write(": ");
+    mAfterKey = true;
+}
+
+void JsonWriter::Int(int value)
+{
+    BeginValue();
+    mSink.Write(std::to_string(value));
+}
+
+void JsonWriter::String(std::string_view value)
+{
+    BeginValue();
+    WriteQuoted(value);
+}
+
+void JsonWriter::Raw(std::string_view json)
+{
+    BeginValue();
+    mSink.Write(json);
+}
+
+void JsonWriter::Splice(std::string_view fragment)
+{
+    if (fragment.empty())
+    {
+        return;
+    }
+
+    // The fragment writer didn't know about any members before it, so it starts without a separator
+    if (mHasMembers.back())
+    {
+        mSink.Write(",");
+    }
+    mSink.Write(fragment);
+    mHasMembers.back() = true;
+}
+
+void JsonWriter::BeginValue()
+{
+    if (mAfterKey)
+    {
+        mAfterKey = false;
+    }
+    else if (!mHasMembers.empty())
+    {
+        // Array element
+        NewMember();
+    }
+}
+
+void JsonWriter::EndContainer(char close)
+{
+    const bool hadMembers = mHasMembers.back();
+    mHasMembers.pop_back();
+    if (hadMembers)
+    {
+        mSink.Write("\n");
+        WriteIndent(mHasMembers.size());
+    }
+    mSink.Write(std::string_view(&close, 1));
+
+    if (mHasMembers.empty())
+    {
+        mSink.Write("\n");
+    }
+}
+
+void JsonWriter::NewMember()
+{
+    mSink.Write(mHasMembers.back() ? ",\n" : "\n");
+    mHasMembers.back() = true;
+    WriteIndent(mHasMembers.size());
+}
+
+void JsonWriter::WriteIndent(size_t depth)
+{
+    static const std::string kTabs(16, '\t');
+    while (depth > 0)
+    {
+        const size_t count = std::min(depth, kTabs.size());
+        mSink.Write(std::string_view(kTabs.data(), count));
+        depth -= count;
+    }
+}
+
+void JsonWriter::WriteQuoted(std::string_view value)
+{
+    mSink.Write("\"");
+
+    // Write runs of characters that don't need escaping in one go, base64 images never need escaping so they
+    // end up as a single write
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        mSink.Write(value.substr(runStart, i - runStart));
+        runStart = i + 1;
+
+        switch (c)
+        {
+        case '"':
+            mSink.Write("\\\"");
+            break;
+
+        case '\\':
+            mSink.Write("\\\\");
+            break;
+
+        case '\b':
+            mSink.Write("\\b");
+            break;
+
+        case '\f':
+            mSink.Write("\\f");
+            break;
+
+        case '\n':
+            mSink.Write("\\n");
+            break;
+
+        case '\r':
+            mSink.Write("\\r");
+            break;
+
+        case '\t':
+            mSink.Write("\\t");
+            break;
+
+        default:
+        {
+            static const char kHex[] = "0123456789abcdef";
+            const char escaped[] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF] };
+            mSink.Write(std::string_view(escaped, sizeof(escaped)));
+            break;
+        }
+        }
+    }
+    mSink.Write(value.substr(runStart));
+
+    mSink.Write("\"");
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ContentHash.hpp"
+
+namespace ReliveAPI
+{
+    class IFile;
+}
+
+// Where JsonWriter sends its output
+class IJsonSink
+{
+public:
+    virtual ~IJsonSink() = default;
+    virtual void Write(std::string_view data) = 0;
+};
+
+class StringJsonSink final : public IJsonSink
+{
+public:
+    void Write(std::string_view data) override
+    {
+        mString.append(data);
+    }
+
+    std::string& String()
+    {
+        return mString;
+    }
+
+private:
+    std::string mString;
+};
+
+// Collects small writes into a buffer so each token doesn't cost a call to the file, big writes such as camera
+// images skip the buffer and go straight to the file.
+class FileJsonSink final : public IJsonSink
+{
+public:
+    explicit FileJsonSink(ReliveAPI::IFile& file);
+
+    void Write(std::string_view data) override;
+
+    // Returns false if anything failed to be written
+    bool Flush();
+
+    // Hash of everything written so far, lets the model cache know which file contents it matches
+    uint64_t Hash() const
+    {
+        return mHasher.Final();
+    }
+
+private:
+    void WriteToFile(std::string_view data);
+
+    ReliveAPI::IFile& mFile;
+    ContentHasher mHasher;
+    std::vector<char> mBuffer;
+    size_t mUsed = 0;
+    bool mOk = true;
+};
+
+// Writes tab indented json to a sink as it goes, members are written in the order they are given
+class JsonWriter final
+{
+public:
+    explicit JsonWriter(IJsonSink& sink);
+
+    // Writes a fragment of members or elements of a container that another writer has open at the given depth,
+    // the output is then added to that writer with Splice(). Lets parts of a document be built in parallel.
+    JsonWriter(IJsonSink& sink, size_t depth);
+
+    // How many containers are open
+    size_t Depth() const
+    {
+        return mHasMembers.size();
+    }
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    void Key(std::string_view key);
+    void Int(int value);
+    void String(std::string_view value);
+
+    // Writes a value that is already json text, such as the schema we loaded
+    void Raw(std::string_view json);
+
+    // Adds the output of a fragment writer that was created with this writers current Depth()
+    void Splice(std::string_view fragment);
+
+private:
+    void BeginValue();
+    void EndContainer(char close);
+    void NewMember();
+    void WriteIndent(size_t depth);
+    void WriteQuoted(std::string_view value);
+
+    IJsonSink& mSink;
+
+    // One entry per open object/array, true once it has a member
+    std::vector<bool> mHasMembers;
+    bool mAfterKey = false;
+};
@@ -1,96 +1,121 @@
 #include "Model.hpp"
+#include "JsonReader.hpp"
+#include "ModelSnapshot.hpp"
+#include "ParallelFor.hpp"
+#include "BinaryStream.hpp"
+#include "ContentHash.hpp"
 #include "ReliveApiWrapper.hpp"
+#include <algorithm>
 #include <optional>
+#include <atomic>
+#include <mutex>
+#include <iterator>
 #include <fstream>
 
 static std::optional<std::string> LoadFileToString(const std::string& fileName)
 {
     EditorFileIO fileIo;
     auto file = fileIo.Open(fileName, ReliveAPI::IFileIO::Mode::ReadBinary);
-    if (!file->IsOpen())
+    if (!file)
     {
         return {};
     }
     std::string s;
     file->ReadInto(s);
-    return { s };
+    return { std::move(s) };
 }
 
-static jsonxx::Array ReadArray(jsonxx::Object& o, const std::string& key)
+static JsonArray ReadArray(const JsonObject& o, const std::string& key)
 {
-    if (!o.has<jsonxx::Array>(key))
+    const JsonValue* pValue = o.Find(key);
+    if (!pValue || pValue->GetType() != JsonValue::Type::Array)
     {
         throw JsonKeyNotFoundException(key);
     }
-    return o.get<jsonxx::Array>(key);
+    return JsonArray(*pValue);
 }
 
-static jsonxx::Object ReadObject(jsonxx::Object& o, const std::string& key)
+static JsonObject ReadObject(const JsonObject& o, const std::string& key)
 {
-    if (!o.has<jsonxx::Object>(key))
+    const JsonValue* pValue = o.Find(key);
+    if (!pValue || pValue->GetType() != JsonValue::Type::Object)
     {
         throw JsonKeyNotFoundException(key);
     }
-    return o.get<jsonxx::Object>(key);
+    return JsonObject(*pValue);
 }
 
-static int ReadNumber(jsonxx::Object& o, const std::string& key)
+static int ReadNumber(const JsonObject& o, const std::string& key)
 {
-    if (!o.has<jsonxx::Number>(key))
+    const JsonValue* pValue = o.Find(key);
+    if (!pValue || pValue->GetType() != JsonValue::Type::Number)
     {
         throw JsonKeyNotFoundException(key);
     }
-    return static_cast<int>(o.get<jsonxx::Number>(key));
+    return pValue->ToInt();
 }
 
-static std::string ReadString(jsonxx::Object& o, const std::string& key)
+static std::string ReadString(const JsonObject& o, const std::string& key)
 {
-    if (!o.has<jsonxx::String>(key))
+    const JsonValue* pValue = o.Find(key);
+    if (!pValue || pValue->GetType() != JsonValue::Type::String)
     {
         throw JsonKeyNotFoundException(key);
     }
-    return o.get<jsonxx::String>(key);
+    return pValue->ToString();
 }
 
-static std::string ReadStringOptional(jsonxx::Object& o, const std::string& key)
+static std::string ReadStringOptional(const JsonObject& o, const std::string& key)
 {
-    if (!o.has<jsonxx::String>(key))
+    const JsonValue* pValue = o.Find(key);
+    if (!pValue || pValue->GetType() != JsonValue::Type::String)
     {
         return "";
     }
-    return o.get<jsonxx::String>(key);
+    return pValue->ToString();
 }
 
-static bool ReadBool(jsonxx::Object& o, const std::string& key)
+static bool ReadBool(const JsonObject& o, const std::string& key)
 {
-    if (!o.has<jsonxx::Boolean>(key))
+    const JsonValue* pValue = o.Find(key);
+    if (!pValue || pValue->GetType() != JsonValue::Type::Boolean)
     {
         throw JsonKeyNotFoundException(key);
     }
-    return o.get<jsonxx::Boolean>(key);
+    return pValue->ToBool();
 }
 
-static std::vector<EnumOrBasicTypeProperty> ReadObjectStructureProperties(jsonxx::Array& enumAndBasicTypes)
+static std::string ReadArrayString(const JsonValue& value)
+{
+    if (value.GetType() != JsonValue::Type::String)
+    {
+        throw InvalidJsonException();
+    }
+    return value.ToString();
+}
+
+static std::vector<EnumOrBasicTypeProperty> ReadObjectStructureProperties(const JsonArray& enumAndBasicTypes)
 {
     std::vector<EnumOrBasicTypeProperty> properties;
-    for (size_t j = 0; j < enumAndBasicTypes.size(); j++)
+    properties.reserve(enumAndBasicTypes.size());
+    for (const JsonValue& enumOrBasicTypeValue : enumAndBasicTypes)
     {
-        jsonxx::Object enumOrBasicType = enumAndBasicTypes.get<jsonxx::Object>(static_cast<unsigned int>(j));
+        const JsonObject enumOrBasicType(enumOrBasicTypeValue);
         EnumOrBasicTypeProperty tmpEnumOrBasicTypeProperty;
         tmpEnumOrBasicTypeProperty.mName = ReadString(enumOrBasicType, "name");
         tmpEnumOrBasicTypeProperty.mType = ReadString(enumOrBasicType, "Type");
         tmpEnumOrBasicTypeProperty.mVisible = ReadBool(enumOrBasicType, "Visible");
-        properties.push_back(tmpEnumOrBasicTypeProperty);
+        properties.push_back(std::move(tmpEnumOrBasicTypeProperty));
     }
     return properties;
 }
 
-static UP_ObjectStructure ReadObjectStructure(jsonxx::Object& objectStructure)
+static std::shared_ptr<ObjectStructure> ReadObjectStructure(const JsonObject& objectStructure)
 {
-    auto tmpObjectStructure = std::make_unique<ObjectStructure>();
+    auto tmpObjectStructure = std::make_shared<ObjectStructure>();
     tmpObjectStructure->mName = ReadString(objectStructure, "name");
 
-    jsonxx::Array enumAndBasicTypes = ReadArray(objectStructure, "enum_and_basic_type_properties");
+    const JsonArray enumAndBasicTypes = ReadArray(objectStructure, "enum_and_basic_type_properties");
     tmpObjectStructure->mEnumAndBasicTypeProperties = ReadObjectStructureProperties(enumAndBasicTypes);
 
     return tmpObjectStructure;
@@ -98,37 +123,16 @@ static UP_ObjectStructure ReadObjectStructure(jsonxx::Object& objectStructure)
 
 Camera* Model::GetContainingCamera(MapObject* pMapObject)
 {
-    Camera* pContainingCamera = nullptr;
-    for (auto& camera : mCameras)
-    {
-        for (auto& mapObj : camera->mMapObjects)
-        {
-            if (mapObj.get() == pMapObject)
-            {
-                pContainingCamera = camera.get();
-                break;
-            }
-        }
-    }
-    return pContainingCamera;
+    return pMapObject->mContainingCamera;
 }
 
 UP_MapObject Model::TakeFromContainingCamera(MapObject* pMapObject)
 {
-    for (auto& camera : mCameras)
+    if (!pMapObject->mContainingCamera)
     {
-        for (auto it = camera->mMapObjects.begin(); it != camera->mMapObjects.end(); )
-        {
-            if ((*it).get() == pMapObject)
-            {
-                UP_MapObject takenObj((*it).release());
-                camera->mMapObjects.erase(it);
-                return takenObj;
-            }
-            it++;
-        }
+        return nullptr;
     }
-    return nullptr;
+    return pMapObject->mContainingCamera->TakeMapObject(pMapObject);
 }
 
 UP_Camera Model::RemoveCamera(Camera* pCamera)
@@ -137,8 +141,33 @@ UP_Camera Model::RemoveCamera(Camera* pCamera)
     {
         if ((*it).get() == pCamera)
         {
+            ModelChangeBatch batch(*this);
+
             auto ret = std::move(*it);
             mCameras.erase(it);
+
+            for (auto& mapObject : ret->mMapObjects)
+            {
+                UnindexMapObject(*mapObject);
+            }
+            ret->mModel = nullptr;
+            Publish({ ModelChange::CameraRemoved, 0, ret.get() });
+
+            Camera* pCameraAt = CameraAt(ret->mX, ret->mY);
+            if (pCameraAt == ret.get())
+            {
+                // Fall back to another camera at the same position, if there is one
+                pCameraAt = nullptr;
+                for (const auto& camera : mCameras)
+                {
+                    if (camera->mX == ret->mX && camera->mY == ret->mY)
+                    {
+                        pCameraAt = camera.get();
+                        break;
+                    }
+                }
+                mCameraGrid[(ret->mY * mCameraGridXSize) + ret->mX] = pCameraAt;
+            }
             return ret;
         }
         it++;
@@ -148,204 +177,529 @@ UP_Camera Model::RemoveCamera(Camera* pCamera)
 
 void Model::AddCamera(UP_Camera pCamera)
 {
+    ModelChangeBatch batch(*this);
+
+    pCamera->mModel = this;
+    for (auto& mapObject : pCamera->mMapObjects)
+    {
+        IndexMapObject(*mapObject);
+    }
+
     mCameras.push_back(std::move(pCamera));
+    IndexCamera(mCameras.back().get());
+    Publish({ ModelChange::CameraAdded, 0, mCameras.back().get() });
 }
 
-void Model::SwapContainingCamera(MapObject* pMapObject, Camera* pTargetCamera)
+void Model::IndexCameras()
 {
-    pTargetCamera->mMapObjects.push_back(TakeFromContainingCamera(pMapObject));
-}
+    BuildCameraGrid();
 
-UP_ObjectProperty Model::MakeProperty(const Model::FoundType foundTypes, const EnumOrBasicTypeProperty& property, const ObjectStructure* pObjStructure)
-{
-    auto tmpProperty = std::make_unique<ObjectProperty>();
-    tmpProperty->mName = property.mName;
-    tmpProperty->mTypeName = property.mType;
-    tmpProperty->mVisible = property.mVisible;
-    if (foundTypes.mBasicType)
+    // Objects of cameras that were replaced are gone by now so this can't look at what the index has
+    mSpatialIndex.ClearMapObjects();
+    mMapObjectsById.clear();
+    for (const auto& camera : mCameras)
     {
-        tmpProperty->mType = ObjectProperty::Type::BasicType;
-    }
-    else
-    {
-        tmpProperty->mType = ObjectProperty::Type::Enumeration;
+        camera->mModel = this;
+        for (auto& mapObject : camera->mMapObjects)
+        {
+            // Not IndexMapObject() as subscribers are told about all of them at once
+            mapObject->mModel = this;
+            mSpatialIndex.AddMapObject(*mapObject);
+            mMapObjectsById[mapObject->mId] = mapObject.get();
+        }
     }
-    return tmpProperty;
+    Publish({ ModelChange::Reset });
+}
+
+void Model::IndexMapObject(MapObject& mapObject)
+{
+    mapObject.mModel = this;
+    mSpatialIndex.AddMapObject(mapObject);
+    mMapObjectsById[mapObject.mId] = &mapObject;
+    Publish({ ModelChange::MapObjectAdded, mapObject.mId });
+}
+
+void Model::UnindexMapObject(MapObject& mapObject)
+{
+    mSpatialIndex.RemoveMapObject(mapObject);
+    mMapObjectsById.erase(mapObject.mId);
+    mapObject.mModel = nullptr;
+    Publish({ ModelChange::MapObjectRemoved, mapObject.mId });
+}
+
+void Model::OnMapObjectDirty(MapObject& mapObject, ModelChange::Kind kind)
+{
+    // Any property could be the position or size
+    mSpatialIndex.UpdateMapObject(mapObject);
+    Publish({ kind, mapObject.mId });
+}
+
+void Model::OnCollisionDirty(CollisionObject& collision, ModelChange::Kind kind)
+{
+    mSpatialIndex.UpdateCollision(collision);
+    Publish({ kind, collision.mId });
 }
 
-std::vector<UP_ObjectProperty> Model::ReadProperties(const ObjectStructure* pObjStructure, jsonxx::Object& properties)
+int Model::Subscribe(uint32_t kinds, ModelChangeHandler handler)
 {
-    std::vector<UP_ObjectProperty> tmpProperties;
-    for (const EnumOrBasicTypeProperty& property : pObjStructure->mEnumAndBasicTypeProperties)
+    const int token = mNextSubscriberToken++;
+    mSubscribers.push_back({ token, kinds, std::move(handler) });
+    return token;
+}
+
+void Model::Unsubscribe(int token)
+{
+    mSubscribers.erase(std::remove_if(mSubscribers.begin(), mSubscribers.end(), [token](const Subscriber& subscriber)
+        {
+            return subscriber.mToken == token;
+        }), mSubscribers.end());
+}
+
+void Model::BeginChanges()
+{
+    mChangesDepth++;
+}
+
+void Model::EndChanges()
+{
+    if (mChangesDepth > 1)
+    {
+        mChangesDepth--;
+        return;
+    }
+
+    // Ends the batch even if a handler throws, otherwise every change after it would be held back for good
+    struct EndBatch final
     {
-        const FoundType foundTypes = FindType(property.mType);
-        if (!foundTypes.mEnum && !foundTypes.mBasicType)
+        ~EndBatch()
         {
-            // corrupted schema type name has no definition
-            throw ObjectPropertyTypeNotFoundException(property.mName, property.mType);
+            mDepth--;
         }
+        int& mDepth;
+    } endBatch{ mChangesDepth };
+
+    // Still counts as a batch while delivering so what the handlers change waits for the next time around
+    std::vector<ModelChange> wanted;
+    while (!mPendingChanges.empty())
+    {
+        const std::vector<ModelChange> changes = std::move(mPendingChanges);
+        mPendingChanges.clear();
+        mPendingChangeSet.clear();
 
-        auto tmpProperty = MakeProperty(foundTypes, property, pObjStructure);
-        if (foundTypes.mBasicType)
+        // Handlers may subscribe or unsubscribe, anything unsubscribed part way through isn't called
+        const std::vector<Subscriber> subscribers = mSubscribers;
+        for (const Subscriber& subscriber : subscribers)
         {
-            tmpProperty->mBasicTypeValue = ReadNumber(properties, property.mName);
+            wanted.clear();
+            for (const ModelChange& change : changes)
+            {
+                if (change.mKind & subscriber.mKinds)
+                {
+                    wanted.push_back(change);
+                }
+            }
+
+            const bool stillSubscribed = std::any_of(mSubscribers.begin(), mSubscribers.end(), [&](const Subscriber& s)
+                {
+                    return s.mToken == subscriber.mToken;
+                });
+            if (!wanted.empty() && stillSubscribed)
+            {
+                subscriber.mHandler(wanted);
+            }
         }
-        else
+    }
+}
+
+void Model::Publish(const ModelChange& change)
+{
+    // Such as while loading, or from the command line
+    if (mSubscribers.empty())
+    {
+        return;
+    }
+
+    // Only changes that say "look at this again" are the same however many times they happen. Adds and removes are
+    // all kept as the order of them matters, an object removed and added back within a batch is still there.
+    constexpr uint32_t kCollapsibleKinds =
+        ModelChange::MapObjectMoved | ModelChange::MapObjectChanged |
+        ModelChange::CollisionMoved | ModelChange::CollisionChanged | ModelChange::CollisionRelinked |
+        ModelChange::CameraChanged | ModelChange::CameraImagesChanged | ModelChange::Reset;
+
+    BeginChanges();
+    if (!(change.mKind & kCollapsibleKinds) || mPendingChangeSet.insert(change).second)
+    {
+        mPendingChanges.push_back(change);
+    }
+    EndChanges();
+}
+
+size_t Model::ModelChangeHash::operator()(const ModelChange& change) const
+{
+    size_t hash = std::hash<uint32_t>()(change.mKind);
+    hash = (hash * 31) + std::hash<int>()(change.mId);
+    hash = (hash * 31) + std::hash<const Camera*>()(change.mCamera);
+    return hash;
+}
+
+void Model::BuildCameraGrid()
+{
+    // Big enough for the map even if it has no cameras yet so filling it in doesn't keep growing the grid
+    int xSize = std::max(mMapInfo.mXSize, 0);
+    int ySize = std::max(mMapInfo.mYSize, 0);
+    for (const auto& camera : mCameras)
+    {
+        xSize = std::max(xSize, camera->mX + 1);
+        ySize = std::max(ySize, camera->mY + 1);
+    }
+
+    mCameraGridXSize = xSize;
+    mCameraGridYSize = ySize;
+    mCameraGrid.assign(static_cast<size_t>(xSize) * static_cast<size_t>(ySize), nullptr);
+    for (const auto& camera : mCameras)
+    {
+        if (camera->mX >= 0 && camera->mY >= 0)
         {
-            tmpProperty->mEnumValue = ReadString(properties, property.mName);
+            Camera*& pSlot = mCameraGrid[(camera->mY * mCameraGridXSize) + camera->mX];
+            if (!pSlot)
+            {
+                pSlot = camera.get();
+            }
         }
-        tmpProperties.push_back(std::move(tmpProperty));
     }
-    return tmpProperties;
 }
 
-void Model::LoadJsonFromString(const std::string& json)
+void Model::IndexCamera(Camera* pCamera)
 {
-    jsonxx::Object root;
-    if (!root.parse(json))
+    if (pCamera->mX < 0 || pCamera->mY < 0)
     {
-        throw InvalidJsonException();
+        return;
     }
 
-    mMapInfo.mApiVersion = ReadNumber(root, "api_version");
-    mMapInfo.mGame = ReadString(root, "game");
+    if (pCamera->mX >= mCameraGridXSize || pCamera->mY >= mCameraGridYSize)
+    {
+        // The map grew, this camera is in mCameras already so it gets indexed along with the rest
+        BuildCameraGrid();
+        return;
+    }
 
-    jsonxx::Object map = ReadObject(root, "map");
+    Camera*& pSlot = mCameraGrid[(pCamera->mY * mCameraGridXSize) + pCamera->mX];
+    if (!pSlot)
+    {
+        pSlot = pCamera;
+    }
+}
 
-    mMapInfo.mPathBnd = ReadString(map, "path_bnd");
-    mMapInfo.mPathId = ReadNumber(map, "path_id");
-    mMapInfo.mXGridSize = ReadNumber(map, "x_grid_size");
-    mMapInfo.mXSize = ReadNumber(map, "x_size");
-    mMapInfo.mYGridSize = ReadNumber(map, "y_grid_size");
-    mMapInfo.mYSize = ReadNumber(map, "y_size");
+void Model::SwapContainingCamera(MapObject* pMapObject, Camera* pTargetCamera)
+{
+    // Objects that stay in their camera keep their place in it
+    if (pMapObject->mContainingCamera != pTargetCamera)
+    {
+        pTargetCamera->AddMapObject(TakeFromContainingCamera(pMapObject));
+    }
+}
 
-    mMapInfo.mAbeStartXPos = ReadNumber(map, "abe_start_xpos");
-    mMapInfo.mAbeStartYPos = ReadNumber(map, "abe_start_ypos");
-    mMapInfo.mNumMudsInPath = ReadNumber(map, "num_muds_in_path");
-    mMapInfo.mTotalMuds = ReadNumber(map, "total_muds");
-    mMapInfo.mBadEndingMuds = ReadNumber(map, "num_muds_for_bad_ending");
-    mMapInfo.mGoodEndingMuds = ReadNumber(map, "num_muds_for_good_ending");
+// Same order as WellKnownProperty
+static const char* const kWellKnownPropertyNames[] = { "xpos", "ypos", "width", "height", "x1", "y1", "x2", "y2", "Next", "Previous" };
+static_assert(std::size(kWellKnownPropertyNames) == static_cast<size_t>(WellKnownProperty::Count));
 
-    jsonxx::Array LCDScreenMessages = ReadArray(map, "lcdscreen_messages");
-    for (size_t i = 0; i < LCDScreenMessages.size(); i++)
+void Schema::ResolveStructure(ObjectStructure& structure) const
+{
+    for (EnumOrBasicTypeProperty& property : structure.mEnumAndBasicTypeProperties)
     {
-        mMapInfo.mLCDScreenMessages.emplace_back(LCDScreenMessages.get<jsonxx::String>(static_cast<unsigned int>(i)));
+        FoundType foundTypes = FindType(property.mType);
+
+        // Values are indices into the enum so one without any can't hold a value
+        property.mTypeFound = (foundTypes.mEnum && !foundTypes.mEnum->mValues.empty()) || foundTypes.mBasicType;
+        property.mKind = foundTypes.mBasicType ? EnumOrBasicTypeProperty::Type::BasicType : EnumOrBasicTypeProperty::Type::Enumeration;
+        property.mEnum = std::move(foundTypes.mEnum);
+        property.mBasicType = std::move(foundTypes.mBasicType);
     }
 
-    jsonxx::Array hintFlyMessages = ReadArray(map, "hintfly_messages");
-    for (size_t i = 0; i < hintFlyMessages.size(); i++)
+    structure.mWellKnownIndices.fill(-1);
+    for (size_t i = 0; i < structure.mEnumAndBasicTypeProperties.size(); i++)
     {
-        mMapInfo.mHintFlyMessages.emplace_back(hintFlyMessages.get<jsonxx::String>(static_cast<unsigned int>(i)));
+        for (size_t j = 0; j < std::size(kWellKnownPropertyNames); j++)
+        {
+            if (structure.mEnumAndBasicTypeProperties[i].mName == kWellKnownPropertyNames[j])
+            {
+                structure.mWellKnownIndices[j] = static_cast<int>(i);
+            }
+        }
     }
+}
 
-    mSchema = ReadObject(root, "schema");
+ObjectProperties Model::DefaultProperties(const ObjectStructure& structure)
+{
+    ObjectProperties tmpProperties(mArena.get());
+    tmpProperties.reserve(structure.mEnumAndBasicTypeProperties.size());
+    for (const EnumOrBasicTypeProperty& property : structure.mEnumAndBasicTypeProperties)
+    {
+        // Enumerations start at their first value
+        tmpProperties.emplace_back(property);
+    }
+    return tmpProperties;
+}
 
-    jsonxx::Array basicTypes = ReadArray(mSchema, "object_structure_property_basic_types");
-    for (size_t i = 0; i < basicTypes.size(); i++)
+ObjectProperties Model::ReadProperties(const ObjectStructure& structure, const JsonObject& properties)
+{
+    ObjectProperties tmpProperties(mArena.get());
+    tmpProperties.reserve(structure.mEnumAndBasicTypeProperties.size());
+    for (const EnumOrBasicTypeProperty& property : structure.mEnumAndBasicTypeProperties)
     {
-        jsonxx::Object basicType = basicTypes.get<jsonxx::Object>(static_cast<unsigned int>(i));
-        auto tmpBasicType = std::make_unique<BasicType>();
+        if (!property.mTypeFound)
+        {
+            // corrupted schema type name has no definition
+            throw ObjectPropertyTypeNotFoundException(property.mName, property.mType);
+        }
+
+        ObjectProperty& tmpProperty = tmpProperties.emplace_back(property);
+        if (property.mKind == EnumOrBasicTypeProperty::Type::BasicType)
+        {
+            tmpProperty.mBasicTypeValue = ReadNumber(properties, property.mName);
+        }
+        else
+        {
+            const std::string value = ReadString(properties, property.mName);
+            tmpProperty.mEnumValueIndex = property.mEnum->IndexOf(value);
+            if (tmpProperty.mEnumValueIndex == -1)
+            {
+                throw EnumValueNotFoundException(property.mType, value);
+            }
+        }
+    }
+    return tmpProperties;
+}
+
+void Schema::Read(const JsonObject& schema)
+{
+    const JsonArray basicTypes = ReadArray(schema, "object_structure_property_basic_types");
+    for (const JsonValue& basicTypeValue : basicTypes)
+    {
+        const JsonObject basicType(basicTypeValue);
+        auto tmpBasicType = std::make_shared<BasicType>();
         tmpBasicType->mName = ReadString(basicType, "name");
         tmpBasicType->mMaxValue = ReadNumber(basicType, "max_value");
         tmpBasicType->mMinValue = ReadNumber(basicType, "min_value");
-        mBasicTypes.push_back(std::move(tmpBasicType));
+        mBasicTypes.emplace(tmpBasicType->mName, std::move(tmpBasicType));
     }
 
-    jsonxx::Array enums = ReadArray(mSchema, "object_structure_property_enums");
-    for (size_t i = 0; i < enums.size(); i++)
+    const JsonArray enums = ReadArray(schema, "object_structure_property_enums");
+    for (const JsonValue& enumValue : enums)
     {
-        jsonxx::Object enumObject = enums.get<jsonxx::Object>(static_cast<unsigned int>(i));
-        auto tmpEnum = std::make_unique<Enum>();
+        const JsonObject enumObject(enumValue);
+        auto tmpEnum = std::make_shared<Enum>();
         tmpEnum->mName = ReadString(enumObject, "name");
 
-        jsonxx::Array enumValuesArray = ReadArray(enumObject, "values");
-        for (size_t j = 0; j < enumValuesArray.size(); j++)
+        const JsonArray enumValuesArray = ReadArray(enumObject, "values");
+        for (const JsonValue& value : enumValuesArray)
         {
-            tmpEnum->mValues.push_back(enumValuesArray.get<jsonxx::String>(static_cast<unsigned int>(j)));
+            tmpEnum->mValues.push_back(ReadArrayString(value));
         }
-        mEnums.push_back(std::move(tmpEnum));
+        mEnums.emplace(tmpEnum->mName, std::move(tmpEnum));
     }
 
-    jsonxx::Array objectStructures = ReadArray(mSchema, "object_structures");
-    for (size_t i = 0; i < objectStructures.size(); i++)
+    const JsonArray objectStructures = ReadArray(schema, "object_structures");
+    for (const JsonValue& objectStructure : objectStructures)
     {
-        jsonxx::Object objectStructure = objectStructures.get<jsonxx::Object>(static_cast<unsigned int>(i));
-        auto tmpObjectStructure = ReadObjectStructure(objectStructure);
+        auto tmpObjectStructure = ReadObjectStructure(JsonObject(objectStructure));
+        ResolveStructure(*tmpObjectStructure);
+        mObjectStructuresByName.emplace(tmpObjectStructure->mName, tmpObjectStructure);
         mObjectStructures.push_back(std::move(tmpObjectStructure));
     }
+}
+
+void Schema::ReadCollisionStructure(const JsonArray& structure)
+{
+    auto tmpCollisionStructure = std::make_shared<ObjectStructure>();
+    tmpCollisionStructure->mName = "Collision";
+    tmpCollisionStructure->mEnumAndBasicTypeProperties = ReadObjectStructureProperties(structure);
+    ResolveStructure(*tmpCollisionStructure);
+    mCollisionStructure = std::move(tmpCollisionStructure);
+}
+
+SP_ObjectStructure Schema::FindObjectStructure(const std::string& structureName) const
+{
+    const auto it = mObjectStructuresByName.find(structureName);
+    return it != mObjectStructuresByName.end() ? it->second : nullptr;
+}
+
+SP_Enum Schema::FindEnum(const std::string& toFind) const
+{
+    const auto it = mEnums.find(toFind);
+    return it != mEnums.end() ? it->second : nullptr;
+}
 
-    jsonxx::Array cameras = ReadArray(map, "cameras");
-    for (size_t i = 0; i < cameras.size(); i++)
+SP_BasicType Schema::FindBasicType(const std::string& toFind) const
+{
+    const auto it = mBasicTypes.find(toFind);
+    return it != mBasicTypes.end() ? it->second : nullptr;
+}
+
+Schema::FoundType Schema::FindType(const std::string& toFind) const
+{
+    SP_Enum enumType = FindEnum(toFind);
+    if (enumType)
     {
-        jsonxx::Object camera = cameras.get<jsonxx::Object>(static_cast<unsigned int>(i));
+        return { std::move(enumType), nullptr };
+    }
+    return { nullptr, FindBasicType(toFind) };
+}
 
-        auto tmpCamera = std::make_unique<Camera>();
-        tmpCamera->mId = ReadNumber(camera, "id");
-        tmpCamera->mName = ReadString(camera, "name");
-        tmpCamera->mX = ReadNumber(camera, "x");
-        tmpCamera->mY = ReadNumber(camera, "y");
+SP_Schema Schema::Get(const std::string& game, int apiVersion, std::string_view schemaJson, std::string_view collisionStructureJson)
+{
+    // Compiled schemas are only kept while a model has them, so closing every path of a game frees its schema
+    static std::mutex registryMutex;
+    static std::unordered_map<std::string, std::weak_ptr<const Schema>> registry;
 
-        tmpCamera->mCameraImageandLayers.mCameraImage = ReadStringOptional(camera, "image");
-        tmpCamera->mCameraImageandLayers.mForegroundLayer = ReadStringOptional(camera, "foreground_layer");
-        tmpCamera->mCameraImageandLayers.mBackgroundLayer = ReadStringOptional(camera, "background_layer");
-        tmpCamera->mCameraImageandLayers.mForegroundWellLayer = ReadStringOptional(camera, "foreground_well_layer");
-        tmpCamera->mCameraImageandLayers.mBackgroundWellLayer = ReadStringOptional(camera, "background_well_layer");
+    ContentHasher hasher;
+    hasher.Update(schemaJson);
+    hasher.Update(collisionStructureJson);
+    const uint64_t hash = hasher.Final();
+    const std::string key = game + ":" + std::to_string(apiVersion) + ":" + std::to_string(hash);
 
-        if (camera.has<jsonxx::Array>("map_objects"))
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        const auto it = registry.find(key);
+        if (it != registry.end())
         {
-            jsonxx::Array mapObjects = ReadArray(camera, "map_objects");
+            SP_Schema existing = it->second.lock();
 
-            for (size_t j = 0; j < mapObjects.size(); j++)
+            // Compare the text too in case two schemas hash the same
+            if (existing && existing->mJson == schemaJson && existing->mCollisionStructureJson == collisionStructureJson)
             {
-                jsonxx::Object mapObject = mapObjects.get<jsonxx::Object>(static_cast<unsigned int>(j));
-                auto tmpMapObject = std::make_unique<MapObject>();
-                tmpMapObject->mName = ReadString(mapObject, "name");
-                tmpMapObject->mObjectStructureType = ReadString(mapObject, "object_structures_type");
+                return existing;
+            }
+        }
+    }
 
-                if (mapObject.has<jsonxx::Object>("properties"))
-                {
-                    const ObjectStructure* pObjStructure = nullptr;
-                    for (const auto& objStruct : mObjectStructures)
-                    {
-                        if (objStruct->mName == tmpMapObject->mObjectStructureType)
-                        {
-                            pObjStructure = objStruct.get();
-                            break;
-                        }
-                    }
+    auto tmpSchema = std::make_shared<Schema>();
+    tmpSchema->mJson = std::string(schemaJson);
+    tmpSchema->mCollisionStructureJson = std::string(collisionStructureJson);
+    tmpSchema->mHash = hash;
+    tmpSchema->Read(JsonObject(ParseJsonDocument(tmpSchema->mJson)));
+    tmpSchema->ReadCollisionStructure(JsonArray(ParseJsonDocument(tmpSchema->mCollisionStructureJson)));
 
-                    if (!pObjStructure)
-                    {
-                        throw JsonKeyNotFoundException(tmpMapObject->mObjectStructureType);
-                    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto it = registry.begin(); it != registry.end(); )
+    {
+        it = it->second.expired() ? registry.erase(it) : std::next(it);
+    }
+    registry[key] = tmpSchema;
+    return tmpSchema;
+}
 
-                    jsonxx::Object properties = ReadObject(mapObject, "properties");
-                    tmpMapObject->mProperties = ReadProperties(pObjStructure, properties);
+UP_Camera Model::ReadCamera(const JsonObject& camera)
+{
+    auto tmpCamera = MakeInArena<Camera>(mArena.get());
+    tmpCamera->mId = ReadNumber(camera, "id");
+    tmpCamera->mName = ReadString(camera, "name");
+    tmpCamera->mX = ReadNumber(camera, "x");
+    tmpCamera->mY = ReadNumber(camera, "y");
+
+    auto images = std::make_shared<Camera::CameraImageAndLayers>();
+    images->mCameraImage = ReadStringOptional(camera, "image");
+    images->mForegroundLayer = ReadStringOptional(camera, "foreground_layer");
+    images->mBackgroundLayer = ReadStringOptional(camera, "background_layer");
+    images->mForegroundWellLayer = ReadStringOptional(camera, "foreground_well_layer");
+    images->mBackgroundWellLayer = ReadStringOptional(camera, "background_well_layer");
+    tmpCamera->mCameraImageandLayers = std::move(images);
+
+    if (camera.Has("map_objects", JsonValue::Type::Array))
+    {
+        const JsonArray mapObjects = ReadArray(camera, "map_objects");
+        tmpCamera->mMapObjects.reserve(mapObjects.size());
+
+        for (const JsonValue& mapObjectValue : mapObjects)
+        {
+            const JsonObject mapObject(mapObjectValue);
+            auto tmpMapObject = MakeInArena<MapObject>(mArena.get(), mArena.get());
+            tmpMapObject->mName = ReadString(mapObject, "name");
+            tmpMapObject->mObjectStructureType = ReadString(mapObject, "object_structures_type");
+
+            if (mapObject.Has("properties", JsonValue::Type::Object))
+            {
+                tmpMapObject->mStructure = mSchema->FindObjectStructure(tmpMapObject->mObjectStructureType);
+                if (!tmpMapObject->mStructure)
+                {
+                    throw JsonKeyNotFoundException(tmpMapObject->mObjectStructureType);
                 }
 
-                tmpCamera->mMapObjects.push_back(std::move(tmpMapObject));
+                const JsonObject properties = ReadObject(mapObject, "properties");
+                tmpMapObject->mProperties = ReadProperties(*tmpMapObject->mStructure, properties);
             }
+
+            tmpCamera->AddMapObject(std::move(tmpMapObject));
         }
-        mCameras.push_back(std::move(tmpCamera));
     }
+    return tmpCamera;
+}
+
+void Model::LoadJsonFromString(const std::string& json)
+{
+    // Only the extents of each member are found here, nothing is decoded until its read below
+    const JsonObject root(ParseJsonDocument(json));
+
+    mMapInfo.mApiVersion = ReadNumber(root, "api_version");
+    mMapInfo.mGame = ReadString(root, "game");
+
+    const JsonObject map = ReadObject(root, "map");
+
+    mMapInfo.mPathBnd = ReadString(map, "path_bnd");
+    mMapInfo.mPathId = ReadNumber(map, "path_id");
+    mMapInfo.mXGridSize = ReadNumber(map, "x_grid_size");
+    mMapInfo.mXSize = ReadNumber(map, "x_size");
+    mMapInfo.mYGridSize = ReadNumber(map, "y_grid_size");
+    mMapInfo.mYSize = ReadNumber(map, "y_size");
 
+    mMapInfo.mAbeStartXPos = ReadNumber(map, "abe_start_xpos");
+    mMapInfo.mAbeStartYPos = ReadNumber(map, "abe_start_ypos");
+    mMapInfo.mNumMudsInPath = ReadNumber(map, "num_muds_in_path");
+    mMapInfo.mTotalMuds = ReadNumber(map, "total_muds");
+    mMapInfo.mBadEndingMuds = ReadNumber(map, "num_muds_for_bad_ending");
+    mMapInfo.mGoodEndingMuds = ReadNumber(map, "num_muds_for_good_ending");
+
+    const JsonArray LCDScreenMessages = ReadArray(map, "lcdscreen_messages");
+    for (const JsonValue& msg : LCDScreenMessages)
+    {
+        mMapInfo.mLCDScreenMessages.emplace_back(ReadArrayString(msg));
+    }
 
-    jsonxx::Object collisionObject = ReadObject(map, "collisions");
-    jsonxx::Array collisionsArray = ReadArray(collisionObject, "items");
-    mCollisionStructureSchema = ReadArray(collisionObject, "structure");
+    const JsonArray hintFlyMessages = ReadArray(map, "hintfly_messages");
+    for (const JsonValue& msg : hintFlyMessages)
+    {
+        mMapInfo.mHintFlyMessages.emplace_back(ReadArrayString(msg));
+    }
 
-    mCollisionStructure = std::make_unique<ObjectStructure>();
-    mCollisionStructure->mName = "Collision";
-    mCollisionStructure->mEnumAndBasicTypeProperties = ReadObjectStructureProperties(mCollisionStructureSchema);
+    // The schema is found by its text, reading these first throws for a path without them like parsing it would
+    ReadObject(root, "schema");
+    const JsonObject collisionObject = ReadObject(map, "collisions");
+    const JsonArray collisionsArray = ReadArray(collisionObject, "items");
+    ReadArray(collisionObject, "structure");
+    mSchema = Schema::Get(mMapInfo.mGame, mMapInfo.mApiVersion, root.Find("schema")->Text(), collisionObject.Find("structure")->Text());
+
+    // The schema is only read from here on, so each camera can be parsed on its own thread. Each result goes into
+    // the slot for its index to keep the order the same as the json.
+    const JsonArray cameras = ReadArray(map, "cameras");
+    std::vector<UP_Camera> loadedCameras(cameras.size());
+    ParallelFor(cameras.size(), [&](size_t i)
+    {
+        loadedCameras[i] = ReadCamera(JsonObject(cameras[i]));
+    });
+    mCameras = std::move(loadedCameras);
+    IndexCameras();
 
+    mCollisions.reserve(collisionsArray.size());
     for (size_t i = 0; i < collisionsArray.size(); i++)
     {
-        jsonxx::Object collision = collisionsArray.get<jsonxx::Object>(static_cast<unsigned int>(i));
+        const JsonObject collision(collisionsArray[i]);
 
-        auto tmpCollision = std::make_unique<CollisionObject>(static_cast<int>(i));
-        tmpCollision->mProperties = ReadProperties(mCollisionStructure.get(), collision);
+        auto tmpCollision = MakeInArena<CollisionObject>(mArena.get(), mArena.get(), static_cast<int>(i));
+        tmpCollision->mStructure = mSchema->CollisionStructure();
+        tmpCollision->mProperties = ReadProperties(*tmpCollision->mStructure, collision);
         mCollisions.push_back(std::move(tmpCollision));
     }
+    IndexCollisions();
 
     CreateEmptyCameras();
 }
@@ -359,6 +713,20 @@ void Model::LoadJsonFromFile(const std::string& jsonFile)
     }
 
     LoadJsonFromString(*jsonString);
+    mJsonFileHash = HashContent(*jsonString);
+}
+
+uint64_t NextModelRevision()
+{
+    // Objects are made on worker threads while loading
+    static std::atomic<uint64_t> nextRevision{ 1 };
+    return nextRevision++;
+}
+
+int NextMapObjectId()
+{
+    static std::atomic<int> nextId{ 1 };
+    return nextId++;
 }
 
 void Model::CreateAsNewPath(int newPathId)
@@ -370,169 +738,357 @@ void Model::CreateAsNewPath(int newPathId)
 
     mCameras.clear();
     mCollisions.clear();
+    IndexCollisions();
 
-    auto cam = std::make_unique<Camera>();
+    auto cam = MakeInArena<Camera>(mArena.get());
     cam->mX = 0;
     cam->mY = 0;
     mCameras.emplace_back(std::move(cam));
+    IndexCameras();
 }
 
 std::string Model::ToJson() const
 {
-    jsonxx::Object root;
-
-    root << "api_version" << mMapInfo.mApiVersion;
-    root << "game" << mMapInfo.mGame;
-
-    jsonxx::Object map;
-    map << "path_bnd" << mMapInfo.mPathBnd;
-    map << "path_id" << mMapInfo.mPathId;
-    map << "x_grid_size" << mMapInfo.mXGridSize;
-    map << "x_size" << mMapInfo.mXSize;
-    map << "y_grid_size" << mMapInfo.mYGridSize;
-    map << "y_size" << mMapInfo.mYSize;
+    return Snapshot()->ToJson();
+}
 
-    map << "abe_start_xpos" << mMapInfo.mAbeStartXPos;
-    map << "abe_start_ypos" << mMapInfo.mAbeStartYPos;
+void Model::SaveBinaryProperties(BinaryWriter& writer, const ObjectProperties& properties)
+{
+    // The names and types come from the object structure when loading so only the values are needed
+    writer.Write(static_cast<uint32_t>(properties.size()));
+    for (const auto& property : properties)
+    {
+        switch (property.GetType())
+        {
+        case ObjectProperty::Type::BasicType:
+            writer.Write(static_cast<int32_t>(property.mBasicTypeValue));
+            break;
 
-    map << "num_muds_in_path" << mMapInfo.mNumMudsInPath;
-    map << "total_muds" << mMapInfo.mTotalMuds;
-    map << "num_muds_for_bad_ending" << mMapInfo.mBadEndingMuds;
-    map << "num_muds_for_good_ending" << mMapInfo.mGoodEndingMuds;
+        case ObjectProperty::Type::Enumeration:
+            writer.Write(static_cast<int32_t>(property.mEnumValueIndex));
+            break;
+        }
+    }
+}
 
-    jsonxx::Array LCDScreenMessages;
-    for (const auto& msg : mMapInfo.mLCDScreenMessages)
+ObjectProperties Model::LoadBinaryProperties(BinaryReader& reader, const ObjectStructure* pStructure)
+{
+    ObjectProperties tmpProperties(mArena.get());
+    const uint32_t count = reader.Read<uint32_t>();
+    if (count == 0)
     {
-        LCDScreenMessages << msg;
+        // Objects that had no properties in the json
+        return tmpProperties;
     }
-    map << "lcdscreen_messages" << LCDScreenMessages;
 
-    jsonxx::Array hintFlyMessages;
-    for (const auto& msg : mMapInfo.mHintFlyMessages)
+    if (!pStructure || count != pStructure->mEnumAndBasicTypeProperties.size())
     {
-        hintFlyMessages << msg;
+        throw InvalidBinaryException();
     }
-    map << "hintfly_messages" << hintFlyMessages;
 
-    jsonxx::Array cameras;
-    for (auto& camera : mCameras)
+    tmpProperties.reserve(count);
+    for (const EnumOrBasicTypeProperty& property : pStructure->mEnumAndBasicTypeProperties)
     {
-        if (!camera->mMapObjects.empty() || !camera->mCameraImageandLayers.mCameraImage.empty())
+        if (!property.mTypeFound)
         {
-            jsonxx::Object camObj;
-            camObj << "id" << camera->mId;
-            camObj << "name" << camera->mName;
-            camObj << "x" << camera->mX;
-            camObj << "y" << camera->mY;
+            throw ObjectPropertyTypeNotFoundException(property.mName, property.mType);
+        }
 
-            if (!camera->mCameraImageandLayers.mCameraImage.empty())
+        ObjectProperty& tmpProperty = tmpProperties.emplace_back(property);
+        if (property.mKind == EnumOrBasicTypeProperty::Type::BasicType)
+        {
+            tmpProperty.mBasicTypeValue = reader.Read<int32_t>();
+        }
+        else
+        {
+            tmpProperty.mEnumValueIndex = reader.Read<int32_t>();
+            if (tmpProperty.mEnumValueIndex < 0 || tmpProperty.mEnumValueIndex >= static_cast<int>(property.mEnum->mValues.size()))
             {
-                camObj << "image" << camera->mCameraImageandLayers.mCameraImage;
+                throw InvalidBinaryException();
             }
+        }
+    }
+    return tmpProperties;
+}
 
-            if (!camera->mCameraImageandLayers.mForegroundLayer.empty())
-            {
-                camObj << "foreground_layer" << camera->mCameraImageandLayers.mForegroundLayer;
-            }
+static void SaveBinaryStrings(BinaryWriter& writer, const std::vector<std::string>& strings)
+{
+    writer.Write(static_cast<uint32_t>(strings.size()));
+    for (const auto& str : strings)
+    {
+        writer.WriteString(str);
+    }
+}
 
-            if (!camera->mCameraImageandLayers.mBackgroundLayer.empty())
-            {
-                camObj << "background_layer" << camera->mCameraImageandLayers.mBackgroundLayer;
-            }
+static std::vector<std::string> LoadBinaryStrings(BinaryReader& reader)
+{
+    std::vector<std::string> strings(reader.Read<uint32_t>());
+    for (auto& str : strings)
+    {
+        str = reader.ReadString();
+    }
+    return strings;
+}
 
-            if (!camera->mCameraImageandLayers.mForegroundWellLayer.empty())
-            {
-                camObj << "foreground_well_layer" << camera->mCameraImageandLayers.mForegroundWellLayer;
-            }
+void Model::SaveBinaryMapInfo(BinaryWriter& writer) const
+{
+    SaveBinaryMapInfo(writer, mMapInfo);
+}
 
-            if (!camera->mCameraImageandLayers.mBackgroundWellLayer.empty())
-            {
-                camObj << "background_well_layer" << camera->mCameraImageandLayers.mBackgroundWellLayer;
-            }
+void Model::SaveBinaryMapInfo(BinaryWriter& writer, const MapInfo& mapInfo)
+{
+    writer.Write(static_cast<int32_t>(mapInfo.mApiVersion));
+    writer.WriteString(mapInfo.mGame);
+    writer.WriteString(mapInfo.mPathBnd);
+    writer.Write(static_cast<int32_t>(mapInfo.mPathId));
+    writer.Write(static_cast<int32_t>(mapInfo.mXGridSize));
+    writer.Write(static_cast<int32_t>(mapInfo.mXSize));
+    writer.Write(static_cast<int32_t>(mapInfo.mYGridSize));
+    writer.Write(static_cast<int32_t>(mapInfo.mYSize));
+    writer.Write(static_cast<int32_t>(mapInfo.mAbeStartXPos));
+    writer.Write(static_cast<int32_t>(mapInfo.mAbeStartYPos));
+    writer.Write(static_cast<int32_t>(mapInfo.mNumMudsInPath));
+    writer.Write(static_cast<int32_t>(mapInfo.mTotalMuds));
+    writer.Write(static_cast<int32_t>(mapInfo.mBadEndingMuds));
+    writer.Write(static_cast<int32_t>(mapInfo.mGoodEndingMuds));
+    SaveBinaryStrings(writer, mapInfo.mLCDScreenMessages);
+    SaveBinaryStrings(writer, mapInfo.mHintFlyMessages);
+}
 
-            jsonxx::Array mapObjects;
-            for (auto& mapObject : camera->mMapObjects)
-            {
-                jsonxx::Object mapObj;
-                mapObj << "name" << mapObject->mName;
-                mapObj << "object_structures_type" << mapObject->mObjectStructureType;
-                jsonxx::Object propertiesObject;
-                for (auto& property : mapObject->mProperties)
-                {
-                    switch (property->mType)
-                    {
-                    case ObjectProperty::Type::BasicType:
-                        propertiesObject << property->mName << property->mBasicTypeValue;
-                        break;
+void Model::LoadBinaryMapInfo(BinaryReader& reader)
+{
+    mMapInfo.mApiVersion = reader.Read<int32_t>();
+    mMapInfo.mGame = reader.ReadString();
+    mMapInfo.mPathBnd = reader.ReadString();
+    mMapInfo.mPathId = reader.Read<int32_t>();
+    mMapInfo.mXGridSize = reader.Read<int32_t>();
+    mMapInfo.mXSize = reader.Read<int32_t>();
+    mMapInfo.mYGridSize = reader.Read<int32_t>();
+    mMapInfo.mYSize = reader.Read<int32_t>();
+    mMapInfo.mAbeStartXPos = reader.Read<int32_t>();
+    mMapInfo.mAbeStartYPos = reader.Read<int32_t>();
+    mMapInfo.mNumMudsInPath = reader.Read<int32_t>();
+    mMapInfo.mTotalMuds = reader.Read<int32_t>();
+    mMapInfo.mBadEndingMuds = reader.Read<int32_t>();
+    mMapInfo.mGoodEndingMuds = reader.Read<int32_t>();
+    mMapInfo.mLCDScreenMessages = LoadBinaryStrings(reader);
+    mMapInfo.mHintFlyMessages = LoadBinaryStrings(reader);
+}
 
-                    case ObjectProperty::Type::Enumeration:
-                        propertiesObject << property->mName << property->mEnumValue;
-                        break;
-                    }
-                }
-                mapObj << "properties" << propertiesObject;
-                mapObjects << mapObj;
-            }
-            camObj << "map_objects" << mapObjects;
+void Model::SaveBinaryCamera(BinaryWriter& writer, const Camera& camera) const
+{
+    writer.Write(static_cast<int32_t>(camera.mId));
+    writer.WriteString(camera.mName);
+    writer.Write(static_cast<int32_t>(camera.mX));
+    writer.Write(static_cast<int32_t>(camera.mY));
 
-            cameras << camObj;
-        }
+    writer.Write(static_cast<uint32_t>(camera.mMapObjects.size()));
+    for (const auto& mapObject : camera.mMapObjects)
+    {
+        SaveBinaryMapObject(writer, *mapObject);
     }
+}
 
-    jsonxx::Object collisionsObject;
-    jsonxx::Array collisionItems;
-    for (auto& collision : mCollisions)
+UP_Camera Model::LoadBinaryCamera(BinaryReader& reader)
+{
+    auto tmpCamera = MakeInArena<Camera>(mArena.get());
+    tmpCamera->mId = reader.Read<int32_t>();
+    tmpCamera->mName = reader.ReadString();
+    tmpCamera->mX = reader.Read<int32_t>();
+    tmpCamera->mY = reader.Read<int32_t>();
+
+    const uint32_t mapObjectCount = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < mapObjectCount; i++)
     {
-        jsonxx::Object collisionObj;
-        for (auto& property : collision->mProperties)
-        {
-            switch (property->mType)
-            {
-            case ObjectProperty::Type::BasicType:
-                // Special case handling for next/previous property links, map line Ids to line index
-                if (property->mName == "Previous" || property->mName == "Next")
-                {
-                    collisionObj << property->mName << IndexOfCollisionId(property->mBasicTypeValue);
-                }
-                else
-                {
-                    collisionObj << property->mName << property->mBasicTypeValue;
-                }
-                break;
+        tmpCamera->AddMapObject(LoadBinaryMapObject(reader));
+    }
+    return tmpCamera;
+}
 
-            case ObjectProperty::Type::Enumeration:
-                collisionObj << property->mName << property->mEnumValue;
-                break;
-            }
-        }
-        collisionItems << collisionObj;
+void Model::SaveBinaryMapObject(BinaryWriter& writer, const MapObject& mapObject) const
+{
+    writer.WriteString(mapObject.mName);
+    writer.WriteString(mapObject.mObjectStructureType);
+    SaveBinaryProperties(writer, mapObject.mProperties);
+}
+
+UP_MapObject Model::LoadBinaryMapObject(BinaryReader& reader)
+{
+    auto tmpMapObject = MakeInArena<MapObject>(mArena.get(), mArena.get());
+    tmpMapObject->mName = reader.ReadString();
+    tmpMapObject->mObjectStructureType = reader.ReadString();
+
+    // Like the json, the structure only has to exist if the object has properties
+    SP_ObjectStructure pObjStructure = mSchema->FindObjectStructure(tmpMapObject->mObjectStructureType);
+    tmpMapObject->mProperties = LoadBinaryProperties(reader, pObjStructure.get());
+    if (!tmpMapObject->mProperties.empty())
+    {
+        tmpMapObject->mStructure = std::move(pObjStructure);
+    }
+    return tmpMapObject;
+}
+
+void Model::SaveBinaryCameraImages(BinaryWriter& writer, const Camera& camera)
+{
+    SaveBinaryCameraImages(writer, *camera.mCameraImageandLayers);
+}
+
+void Model::SaveBinaryCameraImages(BinaryWriter& writer, const Camera::CameraImageAndLayers& images)
+{
+    writer.WriteString(images.mCameraImage);
+    writer.WriteString(images.mForegroundLayer);
+    writer.WriteString(images.mBackgroundLayer);
+    writer.WriteString(images.mForegroundWellLayer);
+    writer.WriteString(images.mBackgroundWellLayer);
+}
+
+void Model::LoadBinaryCameraImages(BinaryReader& reader, Camera& camera)
+{
+    auto images = std::make_shared<Camera::CameraImageAndLayers>();
+    images->mCameraImage = reader.ReadString();
+    images->mForegroundLayer = reader.ReadString();
+    images->mBackgroundLayer = reader.ReadString();
+    images->mForegroundWellLayer = reader.ReadString();
+    images->mBackgroundWellLayer = reader.ReadString();
+    camera.mCameraImageandLayers = std::move(images);
+}
+
+void Model::SaveBinaryCollision(BinaryWriter& writer, const CollisionObject& collision) const
+{
+    writer.Write(static_cast<int32_t>(collision.mId));
+    SaveBinaryProperties(writer, collision.mProperties);
+}
+
+UP_CollisionObject Model::LoadBinaryCollision(BinaryReader& reader)
+{
+    auto tmpCollision = MakeInArena<CollisionObject>(mArena.get(), mArena.get(), reader.Read<int32_t>());
+    tmpCollision->mStructure = mSchema->CollisionStructure();
+    tmpCollision->mProperties = LoadBinaryProperties(reader, tmpCollision->mStructure.get());
+    return tmpCollision;
+}
+
+void Model::SaveBinary(BinaryWriter& writer) const
+{
+    // ModelSnapshot::SaveBinary() writes the same layout, keep them in step.
+    // The schema is small so it's kept as json and looked up or parsed again on load
+    writer.WriteString(mSchema->Json());
+    writer.WriteString(mSchema->CollisionStructureJson());
+
+    SaveBinaryMapInfo(writer);
+
+    writer.Write(static_cast<uint32_t>(mCameras.size()));
+    for (const auto& camera : mCameras)
+    {
+        SaveBinaryCamera(writer, *camera);
+        SaveBinaryCameraImages(writer, *camera);
     }
 
-    collisionsObject << "items" << collisionItems;
-    collisionsObject << "structure" << mCollisionStructureSchema;
-    map << "collisions" << collisionsObject;
+    writer.Write(static_cast<uint32_t>(mCollisions.size()));
+    for (const auto& collision : mCollisions)
+    {
+        SaveBinaryCollision(writer, *collision);
+    }
+}
 
-    map << "cameras" << cameras;
-    root << "map" << map;
+void Model::LoadBinary(BinaryReader& reader)
+{
+    const std::string schemaJson = reader.ReadString();
+    const std::string collisionStructureJson = reader.ReadString();
+    LoadBinaryMapInfo(reader);
+    mSchema = Schema::Get(mMapInfo.mGame, mMapInfo.mApiVersion, schemaJson, collisionStructureJson);
 
-    root << "schema" << mSchema;
+    const uint32_t cameraCount = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < cameraCount; i++)
+    {
+        auto tmpCamera = LoadBinaryCamera(reader);
+        LoadBinaryCameraImages(reader, *tmpCamera);
+        mCameras.push_back(std::move(tmpCamera));
+    }
+    IndexCameras();
+
+    const uint32_t collisionCount = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < collisionCount; i++)
+    {
+        mCollisions.push_back(LoadBinaryCollision(reader));
+    }
+    IndexCollisions();
+
+    if (!reader.AtEnd())
+    {
+        throw InvalidBinaryException();
+    }
+}
 
-    return root.json();
+void Model::AddCollisionItem(UP_CollisionObject pItem)
+{
+    mCollisionIndexOfId[pItem->mId] = static_cast<int>(mCollisions.size());
+    mNextCollisionId = std::max(mNextCollisionId, pItem->mId + 1);
+    pItem->mModel = this;
+    mSpatialIndex.AddCollision(*pItem);
+    Publish({ ModelChange::CollisionAdded, pItem->mId });
+    mCollisions.push_back(std::move(pItem));
 }
 
 UP_CollisionObject Model::RemoveCollisionItem(CollisionObject* pItem)
 {
-    for (auto it = mCollisions.begin(); it != mCollisions.end(); )
+    return std::move(RemoveCollisionItems({ pItem }).front());
+}
+
+std::vector<UP_CollisionObject> Model::RemoveCollisionItems(const std::vector<CollisionObject*>& items)
+{
+    std::vector<UP_CollisionObject> removed(items.size());
+    size_t firstIndex = mCollisions.size();
+    for (size_t i = 0; i < items.size(); i++)
     {
-        if ((*it).get() == pItem)
+        const auto found = mCollisionIndexOfId.find(items[i]->mId);
+        if (found == mCollisionIndexOfId.end() || mCollisions[found->second].get() != items[i])
         {
-            auto ret = std::move(*it);
-            mCollisions.erase(it);
-            return ret;
+            continue;
         }
-        it++;
+
+        const size_t index = static_cast<size_t>(found->second);
+        firstIndex = std::min(firstIndex, index);
+        removed[i] = std::move(mCollisions[index]);
+        mCollisionIndexOfId.erase(found);
+        mSpatialIndex.RemoveCollision(*removed[i]);
+        removed[i]->mModel = nullptr;
     }
-    return nullptr;
+
+    // Close up the gaps and renumber what moved down once for all of them, rather than once per line
+    const auto firstRemoved = mCollisions.begin() + static_cast<std::ptrdiff_t>(firstIndex);
+    mCollisions.erase(std::remove(firstRemoved, mCollisions.end(), nullptr), mCollisions.end());
+    for (size_t i = firstIndex; i < mCollisions.size(); i++)
+    {
+        mCollisionIndexOfId[mCollisions[i]->mId] = static_cast<int>(i);
+    }
+
+    for (const UP_CollisionObject& pItem : removed)
+    {
+        if (pItem)
+        {
+            Publish({ ModelChange::CollisionRemoved, pItem->mId });
+        }
+    }
+    return removed;
+}
+
+void Model::IndexCollisions()
+{
+    mCollisionIndexOfId.clear();
+    mCollisionIndexOfId.reserve(mCollisions.size());
+    for (size_t i = 0; i < mCollisions.size(); i++)
+    {
+        mCollisionIndexOfId.emplace(mCollisions[i]->mId, static_cast<int>(i));
+        mNextCollisionId = std::max(mNextCollisionId, mCollisions[i]->mId + 1);
+    }
+
+    mSpatialIndex.ClearCollisions();
+    for (auto& collision : mCollisions)
+    {
+        collision->mModel = this;
+        mSpatialIndex.AddCollision(*collision);
+    }
+    Publish({ ModelChange::Reset });
 }
 
 void Model::CreateEmptyCameras()
@@ -544,54 +1100,139 @@ void Model::CreateEmptyCameras()
         {
             if (!CameraAt(x, y))
             {
-                auto cam = std::make_unique<Camera>();
+                auto cam = MakeInArena<Camera>(mArena.get());
                 cam->mX = x;
                 cam->mY = y;
-                mCameras.emplace_back(std::move(cam));
+                AddCamera(std::move(cam));
             }
         }
     }
 }
 
-ObjectProperty* PropertyByName(const std::string& name, std::vector<UP_ObjectProperty>& props)
+ObjectProperty* PropertyByName(const std::string& name, ObjectProperties& props)
 {
     for (auto& prop : props)
     {
-        if (prop->mName == name)
+        if (prop.Name() == name)
         {
-            return prop.get();
+            return &prop;
         }
     }
     return nullptr;
 }
 
-const ObjectProperty* PropertyByName(const std::string& name, const std::vector<UP_ObjectProperty>& props)
+const ObjectProperty* PropertyByName(const std::string& name, const ObjectProperties& props)
 {
     for (const auto& prop : props)
     {
-        if (prop->mName == name)
+        if (prop.Name() == name)
         {
-            return prop.get();
+            return &prop;
         }
     }
     return nullptr;
 }
 
-MapObject::MapObject(const MapObject& rhs)
-    : mName(rhs.mName),
-      mObjectStructureType(rhs.mObjectStructureType)
+void Camera::AddMapObject(UP_MapObject pMapObject)
 {
-    for (auto& prop : rhs.mProperties)
+    pMapObject->mContainingCamera = this;
+    if (mModel)
     {
-        mProperties.emplace_back(std::make_unique<ObjectProperty>(*prop));
+        mModel->IndexMapObject(*pMapObject);
     }
+    mMapObjects.push_back(std::move(pMapObject));
 }
 
-CollisionObject::CollisionObject(int id, const CollisionObject& rhs)
-    : mId(id)
+UP_MapObject Camera::TakeMapObject(MapObject* pMapObject)
+{
+    // Erased rather than swapped with the last object so the rest keep the order they are saved in
+    for (auto it = mMapObjects.begin(); it != mMapObjects.end(); it++)
+    {
+        if (it->get() == pMapObject)
+        {
+            UP_MapObject takenObj = std::move(*it);
+            mMapObjects.erase(it);
+            takenObj->mContainingCamera = nullptr;
+            if (mModel)
+            {
+                mModel->UnindexMapObject(*takenObj);
+            }
+            return takenObj;
+        }
+    }
+    return nullptr;
+}
+
+void Camera::TakeMapObjectsFrom(Camera& other)
 {
-    for (auto& prop : rhs.mProperties)
+    mMapObjects.reserve(mMapObjects.size() + other.mMapObjects.size());
+    for (auto& mapObject : other.mMapObjects)
     {
-        mProperties.emplace_back(std::make_unique<ObjectProperty>(*prop));
+        mapObject->mContainingCamera = this;
+        if (other.mModel != mModel)
+        {
+            if (other.mModel)
+            {
+                other.mModel->UnindexMapObject(*mapObject);
+            }
+            if (mModel)
+            {
+                mModel->IndexMapObject(*mapObject);
+            }
+        }
+        mMapObjects.push_back(std::move(mapObject));
     }
+    other.mMapObjects.clear();
+}
+
+void Camera::MarkImagesDirty()
+{
+    mImagesRevision = NextModelRevision();
+    if (mModel)
+    {
+        mModel->Publish({ ModelChange::CameraImagesChanged, 0, this });
+    }
+}
+
+void Camera::MarkChanged()
+{
+    if (mModel)
+    {
+        mModel->Publish({ ModelChange::CameraChanged, 0, this });
+    }
+}
+
+void MapObject::MarkDirty(ModelChange::Kind kind)
+{
+    mRevision = NextModelRevision();
+    if (mModel)
+    {
+        mModel->OnMapObjectDirty(*this, kind);
+    }
+}
+
+void CollisionObject::MarkDirty(ModelChange::Kind kind)
+{
+    mRevision = NextModelRevision();
+    if (mModel)
+    {
+        mModel->OnCollisionDirty(*this, kind);
+    }
+}
+
+MapObject::MapObject(const MapObject& rhs)
+    : mName(rhs.mName),
+      mObjectStructureType(rhs.mObjectStructureType),
+      mStructure(rhs.mStructure),
+      mProperties(rhs.mProperties)
+{
+
+}
+
+CollisionObject::CollisionObject(int id, const CollisionObject& rhs)
+    : mStructure(rhs.mStructure),
+      mProperties(rhs.mProperties),
+      mId(id)
+{
+
 }
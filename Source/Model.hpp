@@ -3,7 +3,26 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <jsonxx.h>
+#include <optional>
+#include <cstdint>
+#include <array>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <memory_resource>
+#include "ModelArena.hpp"
+#include "SpatialIndex.hpp"
+
+class JsonObject;
+class JsonArray;
+class JsonWriter;
+class BinaryWriter;
+class BinaryReader;
+class ModelSnapshot;
+struct MapObjectSnapshot;
+struct CameraSnapshot;
+struct CollisionSnapshot;
 
 class ModelException
 {
@@ -25,6 +44,12 @@ class IOReadException final : public ModelException { public: using ModelExcepti
 // Json data failed to parse
 class InvalidJsonException final : public ModelException {};
 
+// Binary data such as a model cache was truncated or didn't make sense
+class InvalidBinaryException final : public ModelException {};
+
+// An object was asked for a property such as its position that it doesn't have, such as one loaded without properties
+class WellKnownPropertyNotFoundException final : public ModelException {};
+
 // Game name in the json isn't AO or AE
 class InvalidGameException final : public ModelException { public: using ModelException::ModelException; };
 
@@ -62,80 +87,387 @@ private:
     std::string mKey;
 };
 
-struct ObjectProperty final
+// A value in the json that isn't one of the values of "enumName"
+class EnumValueNotFoundException final : public ModelException
 {
-    ObjectProperty() = default;
-    ObjectProperty(const ObjectProperty&) = default;
+public:
+    explicit EnumValueNotFoundException(const std::string& enumName, const std::string& value)
+        : ModelException(enumName + ":" + value), mEnumName(enumName), mValue(value)
+    {
+
+    }
+
+    const std::string& EnumName() const { return mEnumName; }
+    const std::string& Value() const { return mValue; }
 
+private:
+    std::string mEnumName;
+    std::string mValue;
+};
+
+struct Enum final
+{
     std::string mName;
-    std::string mTypeName;
-    int mBasicTypeValue = 0;
-    std::string mEnumValue;
-    bool mVisible = true;
+    std::vector<std::string> mValues;
+
+    // Index of value in mValues or -1 if it isn't one of them
+    int IndexOf(const std::string& value) const
+    {
+        for (size_t i = 0; i < mValues.size(); i++)
+        {
+            if (mValues[i] == value)
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+};
+using SP_Enum = std::shared_ptr<const Enum>;
+
+struct BasicType final
+{
+    std::string mName;
+    int mMinValue = 0;
+    int mMaxValue = 0;
+};
+using SP_BasicType = std::shared_ptr<const BasicType>;
+
+// A property of an object structure in the schema. Objects only keep the values of their properties, the name and
+// type of each is read from here.
+struct EnumOrBasicTypeProperty final
+{
     enum class Type
     {
         Enumeration,
         BasicType,
     };
-    Type mType = {};
+
+    std::string mName;
+    std::string mType;
+    bool mVisible = true;
+
+    // What mType names, worked out once the enums and basic types have been read. A name with no type is only an
+    // error if an object of the structure is loaded.
+    Type mKind = {};
+    bool mTypeFound = false;
+
+    // Set when mKind is Enumeration, property values are indices into its values
+    SP_Enum mEnum;
+
+    // Set when mKind is BasicType
+    SP_BasicType mBasicType;
+};
+
+// Properties the editor reads all the time, such as on every mouse move. Where each is in a structure is found once
+// when it's read so objects can go straight to it instead of searching by name.
+enum class WellKnownProperty
+{
+    XPos,
+    YPos,
+    Width,
+    Height,
+    X1,
+    Y1,
+    X2,
+    Y2,
+    Next,
+    Previous,
+    Count,
+};
+
+// Shared by every object of the structure, including copies in the clipboard or a snapshot which can outlive the
+// model that loaded it
+struct ObjectStructure final
+{
+    std::string mName;
+    std::vector<EnumOrBasicTypeProperty> mEnumAndBasicTypeProperties;
+
+    // Index in mEnumAndBasicTypeProperties of each WellKnownProperty, -1 if the structure doesn't have it
+    std::array<int, static_cast<size_t>(WellKnownProperty::Count)> mWellKnownIndices = {};
+
+    int IndexOf(WellKnownProperty property) const
+    {
+        return mWellKnownIndices[static_cast<size_t>(property)];
+    }
+};
+using SP_ObjectStructure = std::shared_ptr<const ObjectStructure>;
+
+// The enums, basic types and object structures a path's json carries. Every path of a game and api version carries
+// the same schema, so it's compiled once and shared by every model that loads it, and never changes after that.
+class Schema final
+{
+public:
+    struct FoundType final
+    {
+        SP_Enum mEnum;
+        SP_BasicType mBasicType;
+    };
+
+    // The schema compiled from the json, which is the one another model already has if it loaded the same json
+    static std::shared_ptr<const Schema> Get(const std::string& game, int apiVersion, std::string_view schemaJson, std::string_view collisionStructureJson);
+
+    // Objects don't need these, each property of a structure points at its type once the schema is read
+    SP_Enum FindEnum(const std::string& toFind) const;
+    SP_BasicType FindBasicType(const std::string& toFind) const;
+    FoundType FindType(const std::string& toFind) const;
+
+    SP_ObjectStructure FindObjectStructure(const std::string& structureName) const;
+
+    const std::vector<SP_ObjectStructure>& ObjectStructures() const
+    {
+        return mObjectStructures;
+    }
+
+    const SP_ObjectStructure& CollisionStructure() const
+    {
+        return mCollisionStructure;
+    }
+
+    // The json the schema was read from, saving writes it back out as it is
+    const std::string& Json() const
+    {
+        return mJson;
+    }
+
+    const std::string& CollisionStructureJson() const
+    {
+        return mCollisionStructureJson;
+    }
+
+    // Hash of both json strings, the same in every editor instance that has loaded the same schema
+    uint64_t Hash() const
+    {
+        return mHash;
+    }
+
+private:
+    void Read(const JsonObject& schema);
+    void ReadCollisionStructure(const JsonArray& structure);
+    void ResolveStructure(ObjectStructure& structure) const;
+
+    std::string mJson;
+    std::string mCollisionStructureJson;
+    uint64_t mHash = 0;
+
+    // By name, if the schema has more than one of a name the first is used
+    std::unordered_map<std::string, SP_Enum> mEnums;
+    std::unordered_map<std::string, SP_BasicType> mBasicTypes;
+    std::unordered_map<std::string, SP_ObjectStructure> mObjectStructuresByName;
+
+    // In schema order for anything that lists them
+    std::vector<SP_ObjectStructure> mObjectStructures;
+
+    SP_ObjectStructure mCollisionStructure;
 };
-using UP_ObjectProperty = std::unique_ptr<ObjectProperty>;
+using SP_Schema = std::shared_ptr<const Schema>;
+
+// The value of one property of an object, objects keep these in the order of their structure's properties. Nothing
+// adds or removes properties once an object is made so pointers to them stay valid for the life of the object.
+struct ObjectProperty final
+{
+    using Type = EnumOrBasicTypeProperty::Type;
+
+    explicit ObjectProperty(const EnumOrBasicTypeProperty& schema) : mSchema(&schema) { }
+    ObjectProperty(const ObjectProperty&) = default;
+    ObjectProperty& operator=(const ObjectProperty&) = default;
+
+    const std::string& Name() const { return mSchema->mName; }
+    const std::string& TypeName() const { return mSchema->mType; }
+    bool Visible() const { return mSchema->mVisible; }
+    Type GetType() const { return mSchema->mKind; }
 
-ObjectProperty* PropertyByName(const std::string& name, std::vector<UP_ObjectProperty>& props);
+    // Enumeration properties only
+    const Enum& GetEnum() const { return *mSchema->mEnum; }
+    const std::string& EnumValue() const { return mSchema->mEnum->mValues[mEnumValueIndex]; }
 
-const ObjectProperty* PropertyByName(const std::string& name, const std::vector<UP_ObjectProperty>& props);
+    // Basic type properties only
+    const BasicType& GetBasicType() const { return *mSchema->mBasicType; }
+
+    int mBasicTypeValue = 0;
+    int mEnumValueIndex = 0;
+
+private:
+    const EnumOrBasicTypeProperty* mSchema = nullptr;
+};
+
+// Property blocks are allocated from the model's arena, copies made outside the model such as snapshots and the
+// clipboard go to the heap
+using ObjectProperties = std::pmr::vector<ObjectProperty>;
+
+ObjectProperty* PropertyByName(const std::string& name, ObjectProperties& props);
+
+// The property of an object the structure has at the given slot, throws if the object doesn't have it
+template<typename Properties>
+auto& WellKnownPropertyOf(const ObjectStructure* pStructure, Properties& properties, WellKnownProperty property)
+{
+    const int index = pStructure ? pStructure->IndexOf(property) : -1;
+    if (index < 0 || static_cast<size_t>(index) >= properties.size())
+    {
+        throw WellKnownPropertyNotFoundException();
+    }
+    return properties[static_cast<size_t>(index)];
+}
+
+const ObjectProperty* PropertyByName(const std::string& name, const ObjectProperties& props);
+
+// Edits give what they change a new revision from here so anything that keeps its own copy of the model, such as the
+// edit journal, can tell what changed since it last looked. Revisions are never reused.
+uint64_t NextModelRevision();
+
+// Every map object gets an id from here when it's made, copies such as those in the clipboard get their own. Ids are
+// never reused so one always means the same object for as long as the editor runs.
+int NextMapObjectId();
+
+struct Camera;
+class Model;
+
+// Something that changed in a model, see Model::Subscribe()
+struct ModelChange final
+{
+    // Each kind is a bit so a subscriber can ask for several at once
+    enum Kind : uint32_t
+    {
+        MapObjectAdded = 1 << 0,
+        MapObjectRemoved = 1 << 1,
+        MapObjectMoved = 1 << 2,
+        MapObjectChanged = 1 << 3,
+        CollisionAdded = 1 << 4,
+        CollisionRemoved = 1 << 5,
+        CollisionMoved = 1 << 6,
+        CollisionChanged = 1 << 7,
+        CollisionRelinked = 1 << 8,
+        CameraAdded = 1 << 9,
+        CameraRemoved = 1 << 10,
+        CameraChanged = 1 << 11,
+        CameraImagesChanged = 1 << 12,
+
+        // Cameras or lines were replaced wholesale, anything kept about them must be built again
+        Reset = 1 << 13,
+
+        All = (1 << 14) - 1,
+    };
+
+    Kind mKind = {};
+
+    // The id of the map object or line, look it up with Model::MapObjectById() or Model::CollisionById() as it may
+    // have been removed again by the time the change is delivered
+    int mId = 0;
+
+    // For the camera kinds, don't read through it for CameraRemoved as the camera may be gone
+    Camera* mCamera = nullptr;
+
+    bool operator==(const ModelChange& rhs) const
+    {
+        return mKind == rhs.mKind && mId == rhs.mId && mCamera == rhs.mCamera;
+    }
+};
+
+// Changes are delivered in the order they happened. A move or change that happens more than once in a batch is only
+// delivered the first time, every add and remove is delivered.
+using ModelChangeHandler = std::function<void(const std::vector<ModelChange>& changes)>;
 
 struct MapObject final
 {
     MapObject() = default;
 
+    explicit MapObject(std::pmr::memory_resource* pArena) : mProperties(pArena) { }
+
     MapObject(const MapObject& rhs);
 
+    const int mId = NextMapObjectId();
+
     std::string mName;
     std::string mObjectStructureType;
-    std::vector<UP_ObjectProperty> mProperties;
+
+    // Null for objects that had no properties in the json
+    SP_ObjectStructure mStructure;
+    ObjectProperties mProperties;
+
+    // Anything that edits the name or properties must call MarkDirty() so that the next Model::Snapshot() copies it
+    // again instead of sharing the last copy, along with the json the last save formatted for it. While the object
+    // is in a model this also updates the spatial index and tells the model's subscribers.
+    uint64_t mRevision = NextModelRevision();
+    mutable std::shared_ptr<const MapObjectSnapshot> mSnapshot;
+
+    // The camera whose mMapObjects holds this object, null while nothing does such as when it's in the clipboard or
+    // an undo command. Kept up to date by Camera::AddMapObject() and Camera::TakeMapObject().
+    Camera* mContainingCamera = nullptr;
+
+    // Set while the object is in one of the model's cameras
+    Model* mModel = nullptr;
+
+    // See SpatialIndex
+    SpatialCells mSpatialCells;
+
+    // kind is MapObjectMoved when only the position or size changed
+    void MarkDirty(ModelChange::Kind kind = ModelChange::MapObjectChanged);
+
+    ObjectProperty& Property(WellKnownProperty property)
+    {
+        return WellKnownPropertyOf(mStructure.get(), mProperties, property);
+    }
+
+    const ObjectProperty& Property(WellKnownProperty property) const
+    {
+        return WellKnownPropertyOf(mStructure.get(), mProperties, property);
+    }
 
     int XPos() const 
     {
-        return PropertyByName("xpos", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::XPos).mBasicTypeValue;
     }
 
     void SetXPos(int xpos)
     {
-        PropertyByName("xpos", mProperties)->mBasicTypeValue = xpos;
+        Property(WellKnownProperty::XPos).mBasicTypeValue = xpos;
+        MarkDirty(ModelChange::MapObjectMoved);
     }
 
     int YPos() const
     {
-        return PropertyByName("ypos", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::YPos).mBasicTypeValue;
     }
 
     void SetYPos(int ypos)
     {
-        PropertyByName("ypos", mProperties)->mBasicTypeValue = ypos;
+        Property(WellKnownProperty::YPos).mBasicTypeValue = ypos;
+        MarkDirty(ModelChange::MapObjectMoved);
     }
 
     int Width() const
     {
-        return PropertyByName("width", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::Width).mBasicTypeValue;
     }
 
     void SetWidth(int width)
     {
-        PropertyByName("width", mProperties)->mBasicTypeValue = width;
+        Property(WellKnownProperty::Width).mBasicTypeValue = width;
+        MarkDirty(ModelChange::MapObjectMoved);
     }
 
     int Height() const
     {
-        return PropertyByName("height", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::Height).mBasicTypeValue;
     }
 
     void SetHeight(int height)
     {
-        PropertyByName("height", mProperties)->mBasicTypeValue = height;
+        Property(WellKnownProperty::Height).mBasicTypeValue = height;
+        MarkDirty(ModelChange::MapObjectMoved);
+    }
+
+    // For moving and resizing at once, such as while it's dragged, so it's one change rather than four
+    void SetGeometry(int xpos, int ypos, int width, int height)
+    {
+        Property(WellKnownProperty::XPos).mBasicTypeValue = xpos;
+        Property(WellKnownProperty::YPos).mBasicTypeValue = ypos;
+        Property(WellKnownProperty::Width).mBasicTypeValue = width;
+        Property(WellKnownProperty::Height).mBasicTypeValue = height;
+        MarkDirty(ModelChange::MapObjectMoved);
     }
 };
-using UP_MapObject = std::unique_ptr<MapObject>;
+using UP_MapObject = UP_InArena<MapObject>;
 
 struct Camera final
 {
@@ -143,8 +475,21 @@ struct Camera final
     int mId = 0;
     int mX = 0;
     int mY = 0;
+
+    // Only add and remove objects with the functions below so each knows which camera it's in
     std::vector<UP_MapObject> mMapObjects;
 
+    // Set while the camera is in the model, which indexes the objects added to the camera
+    Model* mModel = nullptr;
+
+    void AddMapObject(UP_MapObject pMapObject);
+
+    // Null if the object isn't in this camera
+    UP_MapObject TakeMapObject(MapObject* pMapObject);
+
+    // Moves all of the objects of other to the end of this camera
+    void TakeMapObjectsFrom(Camera& other);
+
     class CameraImageAndLayers final
     {
     public:
@@ -154,107 +499,138 @@ struct Camera final
         std::string mForegroundWellLayer;
         std::string mBackgroundWellLayer;
     };
-    CameraImageAndLayers mCameraImageandLayers;
+    // Most of a path is these base64 images, so they're shared with snapshots and never changed in place. Anything
+    // that changes them swaps in a new copy with ChangeImages(), or sets new ones and calls MarkImagesDirty().
+    std::shared_ptr<const CameraImageAndLayers> mCameraImageandLayers = std::make_shared<const CameraImageAndLayers>();
+
+    template<typename ChangeFn>
+    void ChangeImages(ChangeFn change)
+    {
+        auto images = std::make_shared<CameraImageAndLayers>(*mCameraImageandLayers);
+        change(*images);
+        mCameraImageandLayers = std::move(images);
+        MarkImagesDirty();
+    }
+
+    void MarkImagesDirty();
+    uint64_t mImagesRevision = NextModelRevision();
+
+    // Anything that changes the name or id must call this so the model's subscribers hear about it
+    void MarkChanged();
 
+    // Shared by snapshots until the camera or one of its objects changes
+    mutable std::shared_ptr<const CameraSnapshot> mSnapshot;
 };
-using UP_Camera = std::unique_ptr<Camera>;
+using UP_Camera = UP_InArena<Camera>;
 
 class CollisionObject final
 {
 public:
     explicit CollisionObject(int id) : mId(id) { }
+
+    CollisionObject(std::pmr::memory_resource* pArena, int id) : mProperties(pArena), mId(id) { }
     
     CollisionObject(const CollisionObject&) = delete;
 
     CollisionObject(int id, const CollisionObject& rhs);
 
-    std::vector<UP_ObjectProperty> mProperties;
+    SP_ObjectStructure mStructure;
+    ObjectProperties mProperties;
 
     // The previous/next in the collision data is the index of the next/previous line. Removing or adding line
     // will cause this to break so we remap to a generated Id that then gets normalized back to indicies on save
     // by looking up the index of the line with the given Id.
     int mId = 0;
 
+    // See MapObject::mRevision
+    uint64_t mRevision = NextModelRevision();
+    mutable std::shared_ptr<const CollisionSnapshot> mSnapshot;
+
+    // Set while the line is in a model
+    Model* mModel = nullptr;
+
+    // See SpatialIndex
+    SpatialCells mSpatialCells;
+
+    // See MapObject::MarkDirty(), kind is CollisionMoved when only the ends moved or CollisionRelinked when only the
+    // next or previous line changed
+    void MarkDirty(ModelChange::Kind kind = ModelChange::CollisionChanged);
+
+    ObjectProperty& Property(WellKnownProperty property)
+    {
+        return WellKnownPropertyOf(mStructure.get(), mProperties, property);
+    }
+
+    const ObjectProperty& Property(WellKnownProperty property) const
+    {
+        return WellKnownPropertyOf(mStructure.get(), mProperties, property);
+    }
+
     int X1() const
     {
-        return PropertyByName("x1", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::X1).mBasicTypeValue;
     }
 
     void SetX1(int x1)
     {
-        PropertyByName("x1", mProperties)->mBasicTypeValue = x1;
+        Property(WellKnownProperty::X1).mBasicTypeValue = x1;
+        MarkDirty(ModelChange::CollisionMoved);
     }
 
     int Y1() const
     {
-        return PropertyByName("y1", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::Y1).mBasicTypeValue;
     }
 
     void SetY1(int y1)
     {
-        PropertyByName("y1", mProperties)->mBasicTypeValue = y1;
+        Property(WellKnownProperty::Y1).mBasicTypeValue = y1;
+        MarkDirty(ModelChange::CollisionMoved);
     }
 
     int X2() const
     {
-        return PropertyByName("x2", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::X2).mBasicTypeValue;
     }
 
     void SetX2(int x2)
     {
-        PropertyByName("x2", mProperties)->mBasicTypeValue = x2;
+        Property(WellKnownProperty::X2).mBasicTypeValue = x2;
+        MarkDirty(ModelChange::CollisionMoved);
     }
 
     int Y2() const
     {
-        return PropertyByName("y2", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::Y2).mBasicTypeValue;
     }
 
     void SetY2(int y2)
     {
-        PropertyByName("y2", mProperties)->mBasicTypeValue = y2;
+        Property(WellKnownProperty::Y2).mBasicTypeValue = y2;
+        MarkDirty(ModelChange::CollisionMoved);
+    }
+
+    // See MapObject::SetGeometry()
+    void SetLine(int x1, int y1, int x2, int y2)
+    {
+        Property(WellKnownProperty::X1).mBasicTypeValue = x1;
+        Property(WellKnownProperty::Y1).mBasicTypeValue = y1;
+        Property(WellKnownProperty::X2).mBasicTypeValue = x2;
+        Property(WellKnownProperty::Y2).mBasicTypeValue = y2;
+        MarkDirty(ModelChange::CollisionMoved);
     }
 
     int Next() const
     {
-        return PropertyByName("Next", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::Next).mBasicTypeValue;
     }
 
     int Previous() const
     {
-        return PropertyByName("Previous", mProperties)->mBasicTypeValue;
+        return Property(WellKnownProperty::Previous).mBasicTypeValue;
     }
 };
-using UP_CollisionObject = std::unique_ptr<CollisionObject>;
-
-struct Enum final
-{
-    std::string mName;
-    std::vector<std::string> mValues;
-};
-using UP_Enum = std::unique_ptr<Enum>;
-
-struct EnumOrBasicTypeProperty final
-{
-    std::string mName;
-    std::string mType;
-    bool mVisible = true;
-};
-
-struct ObjectStructure final
-{
-    std::string mName;
-    std::vector<EnumOrBasicTypeProperty> mEnumAndBasicTypeProperties;
-};
-using UP_ObjectStructure = std::unique_ptr<ObjectStructure>;
-
-struct BasicType final
-{
-    std::string mName;
-    int mMinValue = 0;
-    int mMaxValue = 0;
-};
-using UP_BasicType = std::unique_ptr<BasicType>;
+using UP_CollisionObject = UP_InArena<CollisionObject>;
 
 struct MapInfo final
 {
@@ -283,152 +659,276 @@ struct MapInfo final
 class Model final
 {
 public:
+    Model() = default;
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     void LoadJsonFromString(const std::string& json);
     void LoadJsonFromFile(const std::string& jsonFile);
     void CreateAsNewPath(int newPathId);
     const MapInfo& GetMapInfo() const { return mMapInfo; }
     MapInfo& GetMapInfo() { return mMapInfo; }
 
+    // What the cameras, objects and collisions of the model are allocated from
+    const SP_ModelArena& Arena() const { return mArena; }
+
     Camera* GetContainingCamera(MapObject* pMapObject);
 
     UP_MapObject TakeFromContainingCamera(MapObject* pMapObject);
 
+    // Null if the object or line isn't in the model
+    MapObject* MapObjectById(int id) const
+    {
+        const auto it = mMapObjectsById.find(id);
+        return it != mMapObjectsById.end() ? it->second : nullptr;
+    }
+
+    CollisionObject* CollisionById(int id) const
+    {
+        const int index = IndexOfCollisionId(id);
+        return index != -1 ? mCollisions[index].get() : nullptr;
+    }
+
     UP_Camera RemoveCamera(Camera* pCamera);
     void AddCamera(UP_Camera pCamera);
 
     void SwapContainingCamera(MapObject* pMapObject, Camera* pTargetCamera);
 
-    struct FoundType;
-    UP_ObjectProperty MakeProperty(const Model::FoundType foundTypes, const EnumOrBasicTypeProperty& property, const ObjectStructure* pObjStructure);
+    // A value for every property of the structure for a new object, enums start as their first value
+    ObjectProperties DefaultProperties(const ObjectStructure& structure);
 
-    const std::vector<UP_ObjectStructure>& GetObjectStructures() const 
+    const SP_Schema& GetSchema() const
     {
-        return mObjectStructures;
+        return mSchema;
+    }
+
+    const std::vector<SP_ObjectStructure>& GetObjectStructures() const 
+    {
+        return mSchema->ObjectStructures();
     }
 
     const std::vector<UP_Camera>& GetCameras() const { return mCameras; }
 
+    // Call IndexCameras() after adding, removing or replacing cameras through this
+    std::vector<UP_Camera>& CameraItems() { return mCameras; }
+
+    // The first camera at the position, if there is more than one
     Camera* CameraAt(int x, int y) const
     {
-        for (auto& cam : mCameras)
+        if (x < 0 || y < 0 || x >= mCameraGridXSize || y >= mCameraGridYSize)
         {
-            if (cam->mX == x && cam->mY == y)
-            {
-                return cam.get();
-            }
+            return nullptr;
         }
-        return nullptr;
+        return mCameraGrid[(y * mCameraGridXSize) + x];
     }
 
+    // Builds the grid CameraAt() looks cameras up in, the map objects of the spatial index and MapObjectById() from
+    // scratch
+    void IndexCameras();
+
+    // Call IndexCollisions() after adding, removing or replacing lines through this
     std::vector<UP_CollisionObject>& CollisionItems()
     {
         return mCollisions;
     }
 
-    struct FoundType final
+    const std::vector<UP_CollisionObject>& GetCollisions() const
     {
-        Enum* mEnum = nullptr;
-        BasicType* mBasicType = nullptr;
-    };
+        return mCollisions;
+    }
 
-    Enum* FindEnum(const std::string& toFind)
-    {
-        for (const auto& enumType : mEnums)
-        {
-            if (enumType->mName == toFind)
-            {
-                return enumType.get();
-            }
-        }
-        return nullptr;
+    std::string ToJson() const;
+
+    // A read only copy of the model that a background thread can read or save while this model is edited. Only what
+    // changed since the last snapshot is copied, the rest is shared with it. Finding what changed still looks at the
+    // revision of every camera, object and line, so it takes time in proportion to the size of the path but copies
+    // nothing that didn't change. Must be called on the thread that edits the model.
+    std::shared_ptr<const ModelSnapshot> Snapshot() const;
+
+    // Compact binary form of the whole model used by the model cache
+    void SaveBinary(BinaryWriter& writer) const;
+    void LoadBinary(BinaryReader& reader);
+
+    // The parts SaveBinary()/LoadBinary() are made of, the edit journal saves just the parts that changed.
+    // The camera images are kept apart as they are big and rarely change.
+    void SaveBinaryMapInfo(BinaryWriter& writer) const;
+    void LoadBinaryMapInfo(BinaryReader& reader);
+    void SaveBinaryCamera(BinaryWriter& writer, const Camera& camera) const;
+    UP_Camera LoadBinaryCamera(BinaryReader& reader);
+    static void SaveBinaryCameraImages(BinaryWriter& writer, const Camera& camera);
+    static void LoadBinaryCameraImages(BinaryReader& reader, Camera& camera);
+    void SaveBinaryCollision(BinaryWriter& writer, const CollisionObject& collision) const;
+    UP_CollisionObject LoadBinaryCollision(BinaryReader& reader);
+    void SaveBinaryMapObject(BinaryWriter& writer, const MapObject& mapObject) const;
+    UP_MapObject LoadBinaryMapObject(BinaryReader& reader);
+
+    // Hash of the json file this model was last loaded from or saved to
+    const std::optional<uint64_t>& JsonFileHash() const
+    {
+        return mJsonFileHash;
     }
 
-    BasicType* FindBasicType(const std::string& toFind)
+    void SetJsonFileHash(uint64_t hash)
     {
-        for (const auto& basicType : mBasicTypes)
-        {
-            if (basicType->mName == toFind)
-            {
-                return basicType.get();
-            }
-        }
-        return nullptr;
+        mJsonFileHash = hash;
     }
 
-    FoundType FindType(const std::string& toFind)
+    const SP_ObjectStructure& CollisionStructure() const
     {
-        Enum* enumType = FindEnum(toFind);
-        if (enumType)
-        {
-            return { enumType, nullptr };
-        }
-
-        BasicType* basicType = FindBasicType(toFind);
-        if (basicType)
-        {
-            return { nullptr, basicType };
-        }
-
-        return { nullptr, nullptr };
+        return mSchema->CollisionStructure();
     }
 
-    std::string ToJson() const;
+    void AddCollisionItem(UP_CollisionObject pItem);
+    UP_CollisionObject RemoveCollisionItem(CollisionObject* pItem);
 
-    const ObjectStructure& CollisionStructure() const
+    // Takes many lines out at the cost of one, each comes back at the same position as it was given, or null if it
+    // wasn't in the model
+    std::vector<UP_CollisionObject> RemoveCollisionItems(const std::vector<CollisionObject*>& items);
+
+    // Ids are never handed out twice, not even the id of a line that was removed, so lines taken out of the model by
+    // undo commands can always go back with the id they had
+    int NextCollisionId()
     {
-        return *mCollisionStructure;
+        return mNextCollisionId++;
     }
 
-    UP_CollisionObject RemoveCollisionItem(CollisionObject* pItem);
-
-    int NextCollisionId() const
+    // The first of count ids in a row, for adding many lines at once
+    int ReserveCollisionIds(int count)
     {
-        int biggestId = 0;
-        for (auto& item : mCollisions)
-        {
-            if (item->mId > biggestId)
-            {
-                biggestId = item->mId;
-            }
-        }
-        return biggestId + 1;
+        const int firstId = mNextCollisionId;
+        mNextCollisionId += count;
+        return firstId;
     }
 
     int IndexOfCollisionId(int id) const
     {
-        if (id == -1)
+        const auto it = mCollisionIndexOfId.find(id);
+        if (it == mCollisionIndexOfId.end())
         {
+            // Id wasn't found, bad input json ?
             return -1;
         }
+        return it->second;
+    }
 
-        for (size_t i=0; i<mCollisions.size(); i++)
-        {
-            if (mCollisions[i]->mId == id)
-            {
-                return static_cast<int>(i);
-            }
-        }
+    // Builds the map IndexOfCollisionId() looks ids up in, and the lines of the spatial index, from scratch
+    void IndexCollisions();
 
-        // Id wasn't found, bad input json ?
-        return -1;
+    // Where every object and line in the model is
+    const SpatialIndex& GetSpatialIndex() const
+    {
+        return mSpatialIndex;
     }
 
+    // Calls handler with the changes of the given kinds (ModelChange::Kind values or'd together) until unsubscribed
+    // with the returned token. Handlers are called on the thread that edits the model, and may edit it themselves,
+    // what they change is delivered once every handler has seen the current changes.
+    int Subscribe(uint32_t kinds, ModelChangeHandler handler);
+    void Unsubscribe(int token);
+
+    // Changes made between these are held back and delivered together by the outermost EndChanges(), so an edit that
+    // touches many objects costs subscribers one update. Outside of a batch each change is delivered as it happens.
+    void BeginChanges();
+    void EndChanges();
+
 private:
+    // Cameras call these for the objects added to or taken from them while they are in the model
+    friend struct Camera;
+    void IndexMapObject(MapObject& mapObject);
+    void UnindexMapObject(MapObject& mapObject);
+
+    // From MarkDirty() of the objects and lines in the model
+    friend struct MapObject;
+    friend class CollisionObject;
+    void OnMapObjectDirty(MapObject& mapObject, ModelChange::Kind kind);
+    void OnCollisionDirty(CollisionObject& collision, ModelChange::Kind kind);
+
+    // Delivers the change now, or with the rest of the batch if one is open
+    void Publish(const ModelChange& change);
+
     void CreateEmptyCameras();
+    void BuildCameraGrid();
+    void IndexCamera(Camera* pCamera);
+
+    ObjectProperties ReadProperties(const ObjectStructure& structure, const JsonObject& properties);
 
-    std::vector<UP_ObjectProperty> ReadProperties(const ObjectStructure* pObjStructure, jsonxx::Object& properties);
+    // A snapshot writes the same binary layout as the model, from its own copies of the parts
+    friend class ModelSnapshot;
+    static void SaveBinaryProperties(BinaryWriter& writer, const ObjectProperties& properties);
+    static void SaveBinaryMapInfo(BinaryWriter& writer, const MapInfo& mapInfo);
+    static void SaveBinaryCameraImages(BinaryWriter& writer, const Camera::CameraImageAndLayers& images);
+
+    // Null structure is fine for an object without properties
+    ObjectProperties LoadBinaryProperties(BinaryReader& reader, const ObjectStructure* pStructure);
+    UP_Camera ReadCamera(const JsonObject& camera);
+
+    // Declared first so it's destroyed after everything that was allocated from it
+    SP_ModelArena mArena = std::make_shared<ModelArena>();
+
+    // Objects and lines keep a pointer to the model so it can't be copied or moved
+    SpatialIndex mSpatialIndex;
 
     MapInfo mMapInfo;
     std::vector<UP_Camera> mCameras;
+
+    // A slot for every cell of the map, and any cameras past it, holding the first camera at that position. Cameras
+    // at negative positions aren't in it.
+    std::vector<Camera*> mCameraGrid;
+    int mCameraGridXSize = 0;
+    int mCameraGridYSize = 0;
     std::vector<UP_CollisionObject> mCollisions;
-    UP_ObjectStructure mCollisionStructure;
 
-    std::vector<UP_Enum> mEnums;
-    std::vector<UP_ObjectStructure> mObjectStructures;
-    std::vector<UP_BasicType> mBasicTypes;
+    std::unordered_map<int, MapObject*> mMapObjectsById;
+
+    // Where each line is in mCollisions by its id
+    std::unordered_map<int, int> mCollisionIndexOfId;
+    int mNextCollisionId = 0;
+
+    // Shared with every other model that loaded the same schema
+    SP_Schema mSchema;
+
+    std::optional<uint64_t> mJsonFileHash;
+
+    // The collision ids in the order of the last snapshot, see CollisionSnapshot
+    mutable std::vector<int> mSnapshotCollisionIds;
 
-    // Keep a copy of this so we can save it back out
-    jsonxx::Object mSchema;
-    jsonxx::Array mCollisionStructureSchema;
+    struct Subscriber final
+    {
+        int mToken = 0;
+        uint32_t mKinds = 0;
+        ModelChangeHandler mHandler;
+    };
+    std::vector<Subscriber> mSubscribers;
+    int mNextSubscriberToken = 1;
+
+    // Changes waiting for the outermost EndChanges(), and the moves and changes in it so they aren't queued twice
+    int mChangesDepth = 0;
+    std::vector<ModelChange> mPendingChanges;
+    struct ModelChangeHash final
+    {
+        size_t operator()(const ModelChange& change) const;
+    };
+    std::unordered_set<ModelChange, ModelChangeHash> mPendingChangeSet;
 };
 using UP_Model = std::unique_ptr<Model>;
+
+// Batches the changes made to the model for as long as it's in scope, see Model::BeginChanges()
+class ModelChangeBatch final
+{
+public:
+    explicit ModelChangeBatch(Model& model) : mModel(model)
+    {
+        mModel.BeginChanges();
+    }
+
+    ~ModelChangeBatch()
+    {
+        mModel.EndChanges();
+    }
+
+    ModelChangeBatch(const ModelChangeBatch&) = delete;
+    ModelChangeBatch& operator=(const ModelChangeBatch&) = delete;
+
+private:
+    Model& mModel;
+};
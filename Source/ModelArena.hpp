@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+// Memory for the cameras, objects, collisions and property blocks of one model. Loading a path makes hundreds of
+// thousands of these so they are carved out of a few big blocks instead of each going to the heap, and closing the
+// tab hands the blocks back in one go. The model and the tab that shows it both hold on to the arena so it outlives
+// anything allocated from it, including objects kept by undo commands after they were removed from the model.
+// Cameras are read in parallel when loading so the pool has to be the synchronized one.
+using ModelArena = std::pmr::synchronized_pool_resource;
+using SP_ModelArena = std::shared_ptr<ModelArena>;
+
+// Deletes from the arena an object was made in, or the heap for ones that were made with std::make_unique such as
+// the copies in the clipboard
+template<typename T>
+struct ArenaDelete final
+{
+    ArenaDelete() = default;
+
+    explicit ArenaDelete(std::pmr::memory_resource* pArena) : mArena(pArena) { }
+
+    ArenaDelete(std::default_delete<T>) { }
+
+    void operator()(T* p) const
+    {
+        if (mArena)
+        {
+            p->~T();
+            mArena->deallocate(p, sizeof(T), alignof(T));
+        }
+        else
+        {
+            delete p;
+        }
+    }
+
+    std::pmr::memory_resource* mArena = nullptr;
+};
+
+template<typename T>
+using UP_InArena = std::unique_ptr<T, ArenaDelete<T>>;
+
+// Constructs a T in the arena, T is told about the arena separately if it should put what it allocates in there too
+template<typename T, typename... Args>
+UP_InArena<T> MakeInArena(std::pmr::memory_resource* pArena, Args&&... args)
+{
+    void* p = pArena->allocate(sizeof(T), alignof(T));
+    try
+    {
+        return UP_InArena<T>(new (p) T(std::forward<Args>(args)...), ArenaDelete<T>(pArena));
+    }
+    catch (...)
+    {
+        pArena->deallocate(p, sizeof(T), alignof(T));
+        throw;
+    }
+}
@@ -0,0 +1,137 @@
+#include "ModelCache.hpp"
+#include "BinaryStream.hpp"
+#include "ContentHash.hpp"
+#include "ModelSnapshot.hpp"
+#include "ReliveApiWrapper.hpp"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+
+// Layout:
+// header: magic, version, json size, json modified time, json hash, model size
+// model block (Model::SaveBinary)
+constexpr uint32_t kModelCacheMagic = 0x43455451; // "QTEC"
+constexpr uint32_t kModelCacheVersion = 4;
+
+static int64_t JsonModifiedTime(const QFileInfo& jsonInfo)
+{
+    return jsonInfo.lastModified().toMSecsSinceEpoch();
+}
+
+static bool JsonFileHashMatches(const QString& jsonFileName, qint64 size, uint64_t hash)
+{
+    // The hash is of the json itself so a compressed one has to be inflated to check it, which is still far quicker
+    // than parsing it
+    if (IsCompressedJsonFileName(jsonFileName.toStdString()))
+    {
+        EditorFileIO fileIo;
+        auto file = fileIo.Open(jsonFileName.toStdString(), ReliveAPI::IFileIO::Mode::ReadBinary);
+        std::string json;
+        return file && file->ReadInto(json) && HashContent(json) == hash;
+    }
+
+    QFile jsonFile(jsonFileName);
+    if (!jsonFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    const uchar* pJson = jsonFile.map(0, size);
+    if (!pJson)
+    {
+        return false;
+    }
+
+    return HashContent(std::string_view(reinterpret_cast<const char*>(pJson), static_cast<size_t>(size))) == hash;
+}
+
+QString ModelCacheFileName(const QString& jsonFileName)
+{
+    return jsonFileName + ".qtecache";
+}
+
+UP_Model LoadModelCache(const QString& jsonFileName)
+{
+    const QFileInfo jsonInfo(jsonFileName);
+    QFile cacheFile(ModelCacheFileName(jsonFileName));
+    if (!jsonInfo.exists() || !cacheFile.open(QIODevice::ReadOnly))
+    {
+        return nullptr;
+    }
+
+    const qint64 cacheSize = cacheFile.size();
+    const uchar* pCache = cacheFile.map(0, cacheSize);
+    if (!pCache)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        BinaryReader reader(reinterpret_cast<const char*>(pCache), static_cast<size_t>(cacheSize));
+        if (reader.Read<uint32_t>() != kModelCacheMagic || reader.Read<uint32_t>() != kModelCacheVersion)
+        {
+            return nullptr;
+        }
+
+        // Check the cheap things first, the hash catches edits that kept the size and time
+        const uint64_t jsonSize = reader.Read<uint64_t>();
+        const int64_t jsonModified = reader.Read<int64_t>();
+        const uint64_t jsonHash = reader.Read<uint64_t>();
+        if (jsonSize != static_cast<uint64_t>(jsonInfo.size()) || jsonModified != JsonModifiedTime(jsonInfo))
+        {
+            return nullptr;
+        }
+
+        if (!JsonFileHashMatches(jsonFileName, jsonInfo.size(), jsonHash))
+        {
+            return nullptr;
+        }
+
+        const uint64_t modelSize = reader.Read<uint64_t>();
+        BinaryReader modelReader(reader.ReadBytes(static_cast<size_t>(modelSize)), static_cast<size_t>(modelSize));
+        if (!reader.AtEnd())
+        {
+            return nullptr;
+        }
+
+        auto model = std::make_unique<Model>();
+        model->LoadBinary(modelReader);
+        model->SetJsonFileHash(jsonHash);
+        return model;
+    }
+    catch (const ModelException&)
+    {
+        // Corrupt or written by a different version, load from the json instead
+        return nullptr;
+    }
+}
+
+void SaveModelCache(const ModelSnapshot& snapshot, uint64_t jsonHash, const QString& jsonFileName)
+{
+    const QFileInfo jsonInfo(jsonFileName);
+    if (!jsonInfo.exists())
+    {
+        return;
+    }
+
+    BinaryWriter modelWriter;
+    snapshot.SaveBinary(modelWriter);
+
+    BinaryWriter writer;
+    writer.Write(kModelCacheMagic);
+    writer.Write(kModelCacheVersion);
+    writer.Write(static_cast<uint64_t>(jsonInfo.size()));
+    writer.Write(JsonModifiedTime(jsonInfo));
+    writer.Write(jsonHash);
+    writer.Write(static_cast<uint64_t>(modelWriter.Data().size()));
+
+    QSaveFile file(ModelCacheFileName(jsonFileName));
+    if (file.open(QIODevice::WriteOnly))
+    {
+        file.write(writer.Data().data(), static_cast<qint64>(writer.Data().size()));
+        file.write(modelWriter.Data().data(), static_cast<qint64>(modelWriter.Data().size()));
+        file.commit();
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QString>
+#include <cstdint>
+#include "Model.hpp"
+
+class ModelSnapshot;
+
+// A binary copy of a path json that sits next to it as <json>.qtecache so reopening a path doesn't need to parse the
+// json. The camera images are kept as the base64 PNGs the json has, the model needs those to save and decoding them
+// again on open is cheaper than a cache that holds every camera twice.
+
+QString ModelCacheFileName(const QString& jsonFileName);
+
+// Returns nothing if there is no cache or it doesn't match the json file as it is on disk now
+UP_Model LoadModelCache(const QString& jsonFileName);
+
+// Writes the cache for the json file that has the given hash and holds what the snapshot does. Blocks until it's
+// written so is meant to be run in the background.
+void SaveModelCache(const ModelSnapshot& snapshot, uint64_t jsonHash, const QString& jsonFileName);
@@ -0,0 +1,456 @@
+#include "ModelSnapshot.hpp"
+#include "BinaryStream.hpp"
+#include "JsonWriter.hpp"
+#include "ParallelFor.hpp"
+#include "ReliveApiWrapper.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+static SP_MapObjectSnapshot SnapshotMapObject(const MapObject& mapObject)
+{
+    if (!mapObject.mSnapshot || mapObject.mSnapshot->mRevision != mapObject.mRevision)
+    {
+        auto snapshot = std::make_shared<MapObjectSnapshot>();
+        snapshot->mRevision = mapObject.mRevision;
+        snapshot->mName = mapObject.mName;
+        snapshot->mObjectStructureType = mapObject.mObjectStructureType;
+        snapshot->mStructure = mapObject.mStructure;
+        snapshot->mProperties = mapObject.mProperties;
+        mapObject.mSnapshot = std::move(snapshot);
+    }
+    return mapObject.mSnapshot;
+}
+
+// The objects must have been snapshotted first
+static bool CameraSnapshotMatches(const CameraSnapshot& snapshot, const Camera& camera)
+{
+    if (snapshot.mId != camera.mId || snapshot.mName != camera.mName || snapshot.mX != camera.mX ||
+        snapshot.mY != camera.mY || snapshot.mImages != camera.mCameraImageandLayers ||
+        snapshot.mMapObjects.size() != camera.mMapObjects.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < camera.mMapObjects.size(); i++)
+    {
+        if (snapshot.mMapObjects[i] != camera.mMapObjects[i]->mSnapshot)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static SP_CameraSnapshot SnapshotCamera(const Camera& camera)
+{
+    for (const auto& mapObject : camera.mMapObjects)
+    {
+        SnapshotMapObject(*mapObject);
+    }
+
+    if (camera.mSnapshot && CameraSnapshotMatches(*camera.mSnapshot, camera))
+    {
+        return camera.mSnapshot;
+    }
+
+    auto snapshot = std::make_shared<CameraSnapshot>();
+    snapshot->mName = camera.mName;
+    snapshot->mId = camera.mId;
+    snapshot->mX = camera.mX;
+    snapshot->mY = camera.mY;
+    snapshot->mImages = camera.mCameraImageandLayers;
+
+    snapshot->mMapObjects.reserve(camera.mMapObjects.size());
+    for (const auto& mapObject : camera.mMapObjects)
+    {
+        snapshot->mMapObjects.push_back(mapObject->mSnapshot);
+    }
+    camera.mSnapshot = std::move(snapshot);
+    return camera.mSnapshot;
+}
+
+static SP_CollisionSnapshot SnapshotCollision(const CollisionObject& collision, bool collisionsMoved)
+{
+    if (collisionsMoved || !collision.mSnapshot || collision.mSnapshot->mRevision != collision.mRevision)
+    {
+        auto snapshot = std::make_shared<CollisionSnapshot>();
+        snapshot->mRevision = collision.mRevision;
+        snapshot->mId = collision.mId;
+        snapshot->mStructure = collision.mStructure;
+        snapshot->mProperties = collision.mProperties;
+        collision.mSnapshot = std::move(snapshot);
+    }
+    return collision.mSnapshot;
+}
+
+std::shared_ptr<const ModelSnapshot> Model::Snapshot() const
+{
+    auto snapshot = std::make_shared<ModelSnapshot>();
+    snapshot->mMapInfo = std::make_shared<const MapInfo>(mMapInfo);
+
+    snapshot->mCameras.reserve(mCameras.size());
+    for (const auto& camera : mCameras)
+    {
+        snapshot->mCameras.push_back(SnapshotCamera(*camera));
+    }
+
+    bool collisionsMoved = mSnapshotCollisionIds.size() != mCollisions.size();
+    for (size_t i = 0; i < mCollisions.size() && !collisionsMoved; i++)
+    {
+        collisionsMoved = mSnapshotCollisionIds[i] != mCollisions[i]->mId;
+    }
+
+    if (collisionsMoved)
+    {
+        mSnapshotCollisionIds.clear();
+        for (const auto& collision : mCollisions)
+        {
+            mSnapshotCollisionIds.push_back(collision->mId);
+        }
+    }
+
+    snapshot->mCollisions.reserve(mCollisions.size());
+    for (const auto& collision : mCollisions)
+    {
+        snapshot->mCollisions.push_back(SnapshotCollision(*collision, collisionsMoved));
+    }
+
+    snapshot->mSchema = mSchema;
+    return snapshot;
+}
+
+static void WriteStringArray(JsonWriter& writer, const std::vector<std::string>& strings)
+{
+    writer.BeginArray();
+    for (const auto& str : strings)
+    {
+        writer.String(str);
+    }
+    writer.EndArray();
+}
+
+static void WriteProperties(JsonWriter& writer, const ObjectProperties& properties)
+{
+    writer.BeginObject();
+    for (const auto& property : properties)
+    {
+        writer.Key(property.Name());
+        switch (property.GetType())
+        {
+        case ObjectProperty::Type::BasicType:
+            writer.Int(property.mBasicTypeValue);
+            break;
+
+        case ObjectProperty::Type::Enumeration:
+            writer.String(property.EnumValue());
+            break;
+        }
+    }
+    writer.EndObject();
+}
+
+static void WriteMapObject(JsonWriter& writer, const MapObjectSnapshot& mapObject)
+{
+    writer.BeginObject();
+    writer.Key("name");
+    writer.String(mapObject.mName);
+    writer.Key("object_structures_type");
+    writer.String(mapObject.mObjectStructureType);
+    writer.Key("properties");
+    WriteProperties(writer, mapObject.mProperties);
+    writer.EndObject();
+}
+
+// Everything but the images, which don't need formatting so are left to go straight from the snapshot to the sink.
+// Map objects shared with an earlier snapshot reuse the json a save of that one formatted for them.
+static void WriteCameraMembers(JsonWriter& writer, const CameraSnapshot& camera)
+{
+    writer.Key("id");
+    writer.Int(camera.mId);
+    writer.Key("name");
+    writer.String(camera.mName);
+    writer.Key("x");
+    writer.Int(camera.mX);
+    writer.Key("y");
+    writer.Int(camera.mY);
+
+    writer.Key("map_objects");
+    writer.BeginArray();
+    for (const auto& mapObject : camera.mMapObjects)
+    {
+        writer.Splice(mapObject->mJson.Get([&]()
+        {
+            StringJsonSink sink;
+            JsonWriter objectWriter(sink, writer.Depth());
+            WriteMapObject(objectWriter, *mapObject);
+            return std::move(sink.String());
+        }));
+    }
+    writer.EndArray();
+}
+
+static void WriteCameraImages(JsonWriter& writer, const CameraSnapshot& camera)
+{
+    const auto writeOptional = [&](const char* key, const std::string& image)
+    {
+        if (!image.empty())
+        {
+            writer.Key(key);
+            writer.String(image);
+        }
+    };
+    writeOptional("image", camera.mImages->mCameraImage);
+    writeOptional("foreground_layer", camera.mImages->mForegroundLayer);
+    writeOptional("background_layer", camera.mImages->mBackgroundLayer);
+    writeOptional("foreground_well_layer", camera.mImages->mForegroundWellLayer);
+    writeOptional("background_well_layer", camera.mImages->mBackgroundWellLayer);
+}
+
+static void WriteCollision(JsonWriter& writer, const CollisionSnapshot& collision, const std::unordered_map<int, int>& indexOfId)
+{
+    const auto indexOfCollisionId = [&](int id)
+    {
+        // Id wasn't found, bad input json ?
+        auto it = indexOfId.find(id);
+        return it != indexOfId.end() ? it->second : -1;
+    };
+
+    writer.BeginObject();
+    const int previousIndex = collision.mStructure->IndexOf(WellKnownProperty::Previous);
+    const int nextIndex = collision.mStructure->IndexOf(WellKnownProperty::Next);
+    for (size_t i = 0; i < collision.mProperties.size(); i++)
+    {
+        const ObjectProperty& property = collision.mProperties[i];
+        writer.Key(property.Name());
+        switch (property.GetType())
+        {
+        case ObjectProperty::Type::BasicType:
+            // Special case handling for next/previous property links, map line Ids to line index
+            if (static_cast<int>(i) == previousIndex || static_cast<int>(i) == nextIndex)
+            {
+                writer.Int(indexOfCollisionId(property.mBasicTypeValue));
+            }
+            else
+            {
+                writer.Int(property.mBasicTypeValue);
+            }
+            break;
+
+        case ObjectProperty::Type::Enumeration:
+            writer.String(property.EnumValue());
+            break;
+        }
+    }
+    writer.EndObject();
+}
+
+void ModelSnapshot::WriteCollisions(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    writer.Key("items");
+    writer.BeginArray();
+
+    std::unordered_map<int, int> indexOfId;
+    indexOfId.reserve(mCollisions.size());
+    for (size_t i = 0; i < mCollisions.size(); i++)
+    {
+        indexOfId.emplace(mCollisions[i]->mId, static_cast<int>(i));
+    }
+
+    // Lines are tiny so are formatted in chunks, one chunk per task. Only lines no earlier save formatted need it.
+    constexpr size_t kCollisionsPerChunk = 256;
+    const size_t itemDepth = writer.Depth();
+    const size_t chunkCount = (mCollisions.size() + kCollisionsPerChunk - 1) / kCollisionsPerChunk;
+    std::vector<const std::string*> items(mCollisions.size());
+    ParallelFor(chunkCount, [&](size_t chunk)
+    {
+        const size_t end = std::min(mCollisions.size(), (chunk + 1) * kCollisionsPerChunk);
+        for (size_t i = chunk * kCollisionsPerChunk; i < end; i++)
+        {
+            const CollisionSnapshot& collision = *mCollisions[i];
+            items[i] = &collision.mJson.Get([&]()
+            {
+                StringJsonSink sink;
+                JsonWriter collisionWriter(sink, itemDepth);
+                WriteCollision(collisionWriter, collision, indexOfId);
+                return std::move(sink.String());
+            });
+        }
+    });
+
+    for (const std::string* pItem : items)
+    {
+        writer.Splice(*pItem);
+    }
+    writer.EndArray();
+
+    writer.Key("structure");
+    writer.Raw(mSchema->CollisionStructureJson());
+    writer.EndObject();
+}
+
+void ModelSnapshot::WriteCameras(JsonWriter& writer) const
+{
+    writer.BeginArray();
+
+    std::vector<const CameraSnapshot*> camerasToSave;
+    for (const auto& camera : mCameras)
+    {
+        if (!camera->mMapObjects.empty() || !camera->mImages->mCameraImage.empty())
+        {
+            camerasToSave.push_back(camera.get());
+        }
+    }
+
+    // Each camera is formatted on its own task, then joined up in order
+    const size_t memberDepth = writer.Depth() + 1;
+    std::vector<std::string> fragments(camerasToSave.size());
+    ParallelFor(camerasToSave.size(), [&](size_t i)
+    {
+        StringJsonSink sink;
+        JsonWriter cameraWriter(sink, memberDepth);
+        WriteCameraMembers(cameraWriter, *camerasToSave[i]);
+        fragments[i] = std::move(sink.String());
+    });
+
+    for (size_t i = 0; i < camerasToSave.size(); i++)
+    {
+        writer.BeginObject();
+        writer.Splice(fragments[i]);
+        WriteCameraImages(writer, *camerasToSave[i]);
+        writer.EndObject();
+    }
+    writer.EndArray();
+}
+
+void ModelSnapshot::WriteJson(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    writer.Key("api_version");
+    writer.Int(mMapInfo->mApiVersion);
+    writer.Key("game");
+    writer.String(mMapInfo->mGame);
+
+    writer.Key("map");
+    writer.BeginObject();
+    writer.Key("path_bnd");
+    writer.String(mMapInfo->mPathBnd);
+    writer.Key("path_id");
+    writer.Int(mMapInfo->mPathId);
+    writer.Key("x_grid_size");
+    writer.Int(mMapInfo->mXGridSize);
+    writer.Key("x_size");
+    writer.Int(mMapInfo->mXSize);
+    writer.Key("y_grid_size");
+    writer.Int(mMapInfo->mYGridSize);
+    writer.Key("y_size");
+    writer.Int(mMapInfo->mYSize);
+
+    writer.Key("abe_start_xpos");
+    writer.Int(mMapInfo->mAbeStartXPos);
+    writer.Key("abe_start_ypos");
+    writer.Int(mMapInfo->mAbeStartYPos);
+
+    writer.Key("num_muds_in_path");
+    writer.Int(mMapInfo->mNumMudsInPath);
+    writer.Key("total_muds");
+    writer.Int(mMapInfo->mTotalMuds);
+    writer.Key("num_muds_for_bad_ending");
+    writer.Int(mMapInfo->mBadEndingMuds);
+    writer.Key("num_muds_for_good_ending");
+    writer.Int(mMapInfo->mGoodEndingMuds);
+
+    writer.Key("lcdscreen_messages");
+    WriteStringArray(writer, mMapInfo->mLCDScreenMessages);
+    writer.Key("hintfly_messages");
+    WriteStringArray(writer, mMapInfo->mHintFlyMessages);
+
+    writer.Key("collisions");
+    WriteCollisions(writer);
+
+    writer.Key("cameras");
+    WriteCameras(writer);
+    writer.EndObject();
+
+    // Written back out exactly as it was loaded
+    writer.Key("schema");
+    writer.Raw(mSchema->Json());
+    writer.EndObject();
+}
+
+std::string ModelSnapshot::ToJson() const
+{
+    StringJsonSink sink;
+    JsonWriter writer(sink);
+    WriteJson(writer);
+    return std::move(sink.String());
+}
+
+std::optional<uint64_t> ModelSnapshot::SaveJsonToFile(const std::string& fileName) const
+{
+    // Write next to the target so the rename can't cross file systems, then a failed save leaves the old file alone.
+    // The name says whether to compress so a compressed one keeps its extension.
+    const std::string tempFileName = fileName + (IsCompressedJsonFileName(fileName) ? ".tmp.json.gz" : ".tmp");
+    EditorFileIO fileIo;
+    auto file = fileIo.OpenFile(tempFileName, ReliveAPI::IFileIO::Mode::WriteBinary);
+    if (!file)
+    {
+        return {};
+    }
+
+    FileJsonSink sink(*file);
+    JsonWriter writer(sink);
+    WriteJson(writer);
+    const bool flushed = sink.Flush();
+
+    // Closing writes out whatever the file still has buffered, a compressed file's trailer included. Nothing is
+    // renamed until all of it is on the disk.
+    const bool written = file->Close() && flushed && SyncFileToDisk(tempFileName);
+
+    std::error_code error;
+    if (written)
+    {
+        std::filesystem::rename(std::filesystem::u8path(tempFileName), std::filesystem::u8path(fileName), error);
+    }
+
+    if (!written || error)
+    {
+        std::filesystem::remove(std::filesystem::u8path(tempFileName), error);
+        return {};
+    }
+    return sink.Hash();
+}
+
+void ModelSnapshot::SaveBinary(BinaryWriter& writer) const
+{
+    writer.WriteString(mSchema->Json());
+    writer.WriteString(mSchema->CollisionStructureJson());
+
+    Model::SaveBinaryMapInfo(writer, *mMapInfo);
+
+    writer.Write(static_cast<uint32_t>(mCameras.size()));
+    for (const auto& camera : mCameras)
+    {
+        writer.Write(static_cast<int32_t>(camera->mId));
+        writer.WriteString(camera->mName);
+        writer.Write(static_cast<int32_t>(camera->mX));
+        writer.Write(static_cast<int32_t>(camera->mY));
+
+        writer.Write(static_cast<uint32_t>(camera->mMapObjects.size()));
+        for (const auto& mapObject : camera->mMapObjects)
+        {
+            writer.WriteString(mapObject->mName);
+            writer.WriteString(mapObject->mObjectStructureType);
+            Model::SaveBinaryProperties(writer, mapObject->mProperties);
+        }
+        Model::SaveBinaryCameraImages(writer, *camera->mImages);
+    }
+
+    writer.Write(static_cast<uint32_t>(mCollisions.size()));
+    for (const auto& collision : mCollisions)
+    {
+        writer.Write(static_cast<int32_t>(collision->mId));
+        Model::SaveBinaryProperties(writer, collision->mProperties);
+    }
+}
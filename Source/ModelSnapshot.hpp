@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Model.hpp"
+
+class BinaryWriter;
+class JsonWriter;
+
+// The json an object of a snapshot was formatted as. Snapshot objects never change, so whichever save gets to one
+// first formats it and every later snapshot that still shares the object splices the same text.
+class SnapshotJson final
+{
+public:
+    template<typename FormatFn>
+    const std::string& Get(FormatFn format) const
+    {
+        std::call_once(mFormatted, [&]() { mJson = format(); });
+        return mJson;
+    }
+
+private:
+    mutable std::once_flag mFormatted;
+    mutable std::string mJson;
+};
+
+struct MapObjectSnapshot final
+{
+    uint64_t mRevision = 0;
+    std::string mName;
+    std::string mObjectStructureType;
+    SP_ObjectStructure mStructure;
+    ObjectProperties mProperties;
+    SnapshotJson mJson;
+};
+using SP_MapObjectSnapshot = std::shared_ptr<const MapObjectSnapshot>;
+
+struct CameraSnapshot final
+{
+    std::string mName;
+    int mId = 0;
+    int mX = 0;
+    int mY = 0;
+    // The camera's own images, which are never changed once made
+    std::shared_ptr<const Camera::CameraImageAndLayers> mImages;
+    std::vector<SP_MapObjectSnapshot> mMapObjects;
+};
+using SP_CameraSnapshot = std::shared_ptr<const CameraSnapshot>;
+
+// Next/Previous are written as indices so a line is only ever shared by snapshots with the same order of lines, when
+// lines are added, removed or reordered every line gets a new snapshot
+struct CollisionSnapshot final
+{
+    uint64_t mRevision = 0;
+    int mId = 0;
+    SP_ObjectStructure mStructure;
+    ObjectProperties mProperties;
+    SnapshotJson mJson;
+};
+using SP_CollisionSnapshot = std::shared_ptr<const CollisionSnapshot>;
+
+// A read only copy of a Model that a background thread can read or save while the model is edited, see
+// Model::Snapshot(). The objects that didn't change between two snapshots are shared by them, along with the json
+// saving formatted for them, so a snapshot only costs copying what was edited since the last one.
+class ModelSnapshot final
+{
+public:
+    const MapInfo& GetMapInfo() const
+    {
+        return *mMapInfo;
+    }
+
+    const std::vector<SP_CameraSnapshot>& GetCameras() const
+    {
+        return mCameras;
+    }
+
+    const std::vector<SP_CollisionSnapshot>& GetCollisions() const
+    {
+        return mCollisions;
+    }
+
+    std::string ToJson() const;
+
+    // Writes to a temp file that then replaces fileName, returns the hash of the json or nothing if it failed
+    std::optional<uint64_t> SaveJsonToFile(const std::string& fileName) const;
+
+    // The same as Model::SaveBinary() of the model as it was, so the model cache can be written off the GUI thread
+    void SaveBinary(BinaryWriter& writer) const;
+
+private:
+    friend class Model;
+
+    void WriteJson(JsonWriter& writer) const;
+    void WriteCollisions(JsonWriter& writer) const;
+    void WriteCameras(JsonWriter& writer) const;
+
+    std::shared_ptr<const MapInfo> mMapInfo;
+    std::vector<SP_CameraSnapshot> mCameras;
+    std::vector<SP_CollisionSnapshot> mCollisions;
+    SP_Schema mSchema;
+};
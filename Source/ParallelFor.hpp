@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QtConcurrent/QtConcurrent>
+#include <QFuture>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <vector>
+
+// Calls fn(i) for every i in [0, count) across the global thread pool and returns once they have all finished.
+// The calling thread works through the items as well, so this can't dead lock when called from a pool thread.
+// ModelExceptions aren't QExceptions so they'd be lost crossing QtConcurrent, instead they are caught per item
+// and the one from the lowest index is rethrown here.
+template<typename Fn>
+void ParallelFor(size_t count, Fn fn)
+{
+    std::atomic<size_t> nextIndex{ 0 };
+    std::vector<std::exception_ptr> errors(count);
+
+    const auto worker = [&]()
+    {
+        for (size_t idx = nextIndex++; idx < count; idx = nextIndex++)
+        {
+            try
+            {
+                fn(idx);
+            }
+            catch (...)
+            {
+                errors[idx] = std::current_exception();
+            }
+        }
+    };
+
+    const size_t threadCount = std::min(count, static_cast<size_t>(std::max(QThread::idealThreadCount(), 1)));
+    std::vector<QFuture<void>> helpers;
+    for (size_t i = 1; i < threadCount; i++)
+    {
+        helpers.push_back(QtConcurrent::run(worker));
+    }
+
+    worker();
+
+    for (auto& helper : helpers)
+    {
+        helper.waitForFinished();
+    }
+
+    for (const auto& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -8,12 +8,11 @@ class IGraphicsItem;
 
 struct LinkedProperty
 {
-    LinkedProperty(PropertyTreeWidget* pTreeWidget, ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem)
-        : mTreeWidget(pTreeWidget), mProperty(pProperty), mGraphicsItem(pGraphicsItem)
+    LinkedProperty(ObjectProperty* pProperty, IGraphicsItem* pGraphicsItem)
+        : mProperty(pProperty), mGraphicsItem(pGraphicsItem)
     {
 
     }
-    PropertyTreeWidget* mTreeWidget = nullptr;
     ObjectProperty* mProperty = nullptr;
     IGraphicsItem* mGraphicsItem = nullptr;
 };
@@ -26,6 +25,4 @@ public:
     virtual QWidget* CreateEditorWidget(PropertyTreeWidget* pParent) = 0;
 
     virtual void Refresh() = 0;
-
-    virtual const void* GetPropertyLookUpKey() const = 0;
 };
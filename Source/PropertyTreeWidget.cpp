@@ -8,21 +8,7 @@
 #include "EnumProperty.hpp"
 #include <QHeaderView>
 
-PropertyTreeItemBase* PropertyTreeWidget::FindObjectPropertyByKey(const void* pKey)
-{
-    for (int i = 0; i < topLevelItemCount(); i++)
-    {
-        auto pItem = static_cast<PropertyTreeItemBase*>(topLevelItem(i));
-        const void* itemKey = pItem->GetPropertyLookUpKey();
-        if (itemKey == pKey)
-        {
-            return pItem;
-        }
-    }
-    return nullptr;
-}
-
-void PropertyTreeWidget::Populate(Model& model, QUndoStack& undoStack, QGraphicsItem* pItem)
+void PropertyTreeWidget::Populate(QUndoStack& undoStack, QGraphicsItem* pItem)
 {
     auto pLine = qgraphicsitem_cast<ResizeableArrowItem*>(pItem);
     auto pRect = qgraphicsitem_cast<ResizeableRectItem*>(pItem);
@@ -32,17 +18,19 @@ void PropertyTreeWidget::Populate(Model& model, QUndoStack& undoStack, QGraphics
     if (pRect)
     {
         MapObject* pMapObject = pRect->GetMapObject();
+        mMapObjectId = pMapObject->mId;
 
-        items.append(new StringProperty(undoStack, parent, kIndent + "Name", &pMapObject->mName));
-        AddProperties(model, undoStack, items, pMapObject->mProperties, pRect);
+        items.append(new StringProperty(undoStack, parent, kIndent + "Name", &pMapObject->mName, pRect));
+        AddProperties(undoStack, items, pMapObject->mProperties, pRect);
     }
     else if (pLine)
     {
         CollisionObject* pCollisionItem = pLine->GetCollisionItem();
+        mCollisionId = pCollisionItem->mId;
 
         items.append(new ReadOnlyStringProperty(parent, kIndent + "Id", &pCollisionItem->mId));
 
-        AddProperties(model, undoStack, items, pCollisionItem->mProperties, pLine);
+        AddProperties(undoStack, items, pCollisionItem->mProperties, pLine);
     }
 
     insertTopLevelItems(0, items);
@@ -51,6 +39,8 @@ void PropertyTreeWidget::Populate(Model& model, QUndoStack& undoStack, QGraphics
 void PropertyTreeWidget::DePopulate()
 {
     clear();
+    mMapObjectId.reset();
+    mCollisionId.reset();
 }
 
 void PropertyTreeWidget::Init()
@@ -98,40 +88,39 @@ void PropertyTreeWidget::Init()
         });
 }
 
-void PropertyTreeWidget::Sync(IGraphicsItem* pItem)
+void PropertyTreeWidget::OnModelChanged(const std::vector<ModelChange>& changes)
 {
-    auto& props = pItem->GetProperties();
-    for (auto& prop : props)
+    for (const ModelChange& change : changes)
     {
-        PropertyTreeItemBase* pTreeItem = FindObjectPropertyByKey(prop.get());
-        if (pTreeItem)
+        const bool mapObjectChanged = (change.mKind & (ModelChange::MapObjectMoved | ModelChange::MapObjectChanged)) && change.mId == mMapObjectId;
+        const bool collisionChanged = (change.mKind & (ModelChange::CollisionMoved | ModelChange::CollisionChanged | ModelChange::CollisionRelinked)) && change.mId == mCollisionId;
+        if (mapObjectChanged || collisionChanged)
         {
-            pTreeItem->Refresh();
+            // Every value is refreshed as even a move can change more than one of them
+            for (int i = 0; i < topLevelItemCount(); i++)
+            {
+                static_cast<PropertyTreeItemBase*>(topLevelItem(i))->Refresh();
+            }
+            return;
         }
     }
 }
 
-void PropertyTreeWidget::AddProperties(Model& model, QUndoStack& undoStack, QList<QTreeWidgetItem*>& items, std::vector<UP_ObjectProperty>& props, IGraphicsItem* pGraphicsItem)
+void PropertyTreeWidget::AddProperties(QUndoStack& undoStack, QList<QTreeWidgetItem*>& items, ObjectProperties& props, IGraphicsItem* pGraphicsItem)
 {
     QTreeWidgetItem* parent = nullptr;
-    for (UP_ObjectProperty& property : props)
+    for (ObjectProperty& property : props)
     {
-        if (property->mVisible)
+        if (property.Visible())
         {
-            switch (property->mType)
+            switch (property.GetType())
             {
             case ObjectProperty::Type::BasicType:
-            {
-                BasicType* pBasicType = model.FindBasicType(property->mTypeName);
-                items.append(new BasicTypeProperty(undoStack, parent, kIndent + property->mName.c_str(), property.get(), pGraphicsItem, pBasicType));
-            }
+                items.append(new BasicTypeProperty(undoStack, parent, kIndent + property.Name().c_str(), &property, pGraphicsItem, &property.GetBasicType()));
                 break;
 
             case ObjectProperty::Type::Enumeration:
-            {
-                Enum* pEnum = model.FindEnum(property->mTypeName);
-                items.append(new EnumProperty(undoStack, parent, property.get(), pGraphicsItem, pEnum));
-            }
+                items.append(new EnumProperty(undoStack, parent, &property, pGraphicsItem));
                 break;
             }
         }
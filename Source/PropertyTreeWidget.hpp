@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QTreeWidget>
+#include <optional>
 #include "Model.hpp"
 
 class PropertyTreeItemBase;
@@ -13,28 +14,23 @@ class QUndoStack;
 
 inline const QString kIndent("    ");
 
-class ISyncPropertiesToTree
-{
-public:
-    virtual ~ISyncPropertiesToTree() { }
-    virtual void Sync(IGraphicsItem* pItem) = 0;
-};
-
-
-class PropertyTreeWidget : public ISyncPropertiesToTree, public QTreeWidget
+class PropertyTreeWidget : public QTreeWidget
 {
 public:
     using QTreeWidget::QTreeWidget;
 
-    PropertyTreeItemBase* FindObjectPropertyByKey(const void* pKey);
-
-    void Populate(Model& model, QUndoStack& undoStack, QGraphicsItem* pItem);
+    void Populate(QUndoStack& undoStack, QGraphicsItem* pItem);
     void DePopulate();
 
     void Init();
 
+    // Shows the new values if any of the changes are to the object or line being shown
+    void OnModelChanged(const std::vector<ModelChange>& changes);
+
 private:
-    void Sync(IGraphicsItem* pItem) override;
-    void AddProperties(Model& model, QUndoStack& undoStack, QList<QTreeWidgetItem*>& items, std::vector<UP_ObjectProperty>& props, IGraphicsItem* pGraphicsItem);
+    void AddProperties(QUndoStack& undoStack, QList<QTreeWidgetItem*>& items, ObjectProperties& props, IGraphicsItem* pGraphicsItem);
 
+    // What's being shown, if anything
+    std::optional<int> mMapObjectId;
+    std::optional<int> mCollisionId;
 };
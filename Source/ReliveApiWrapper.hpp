@@ -3,11 +3,32 @@
 #include "relive_api.hpp"
 #include "file_api.hpp"
 #include <functional>
+#include <algorithm>
+#include <vector>
 #include <QString>
 
+#ifdef QT_EDITOR_GZIP
+#include <zlib.h>
+#endif
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 // Implement ReliveAPI::IFileIO override that supports unicode from utf8 on windows
 
-class File final : public ReliveAPI::IFile
+// A file the editor opened itself, which it can close explicitly to find out if the last of a write made it to disk
+class EditorFile : public ReliveAPI::IFile
+{
+public:
+    // Returns false if anything still buffered failed to be written, the file is closed either way
+    virtual bool Close() = 0;
+};
+
+class File final : public EditorFile
 {
 public:
     File(const std::string& fileName, ReliveAPI::IFileIO::Mode mode)
@@ -63,10 +84,18 @@ public:
 
     ~File() override
     {
-        if (IsOpen())
+        Close();
+    }
+
+    bool Close() override
+    {
+        if (!IsOpen())
         {
-            ::fclose(mFileHandle);
+            return true;
         }
+        const bool ok = ::fclose(mFileHandle) == 0;
+        mFileHandle = nullptr;
+        return ok;
     }
 
     bool IsOpen() const override
@@ -134,11 +163,166 @@ private:
     FILE* mFileHandle = nullptr;
 };
 
+// Paths can be kept as gzipped json, anything that reads or writes json through EditorFileIO handles them
+inline bool IsCompressedJsonFileName(const std::string& fileName)
+{
+    return QString::fromStdString(fileName).endsWith(".json.gz", Qt::CaseInsensitive);
+}
+
+// zlib is optional, without it .json.gz files can't be opened or saved. Check names with this first so the user is
+// told why rather than just that it failed.
+constexpr const char kNoGzipSupportMessage[] = "This editor was built without gzip support, so it can't open or save .json.gz files";
+
+inline bool IsJsonFileNameSupported(const std::string& fileName)
+{
+#ifdef QT_EDITOR_GZIP
+    (void)fileName;
+    return true;
+#else
+    return !IsCompressedJsonFileName(fileName);
+#endif
+}
+
+#ifdef QT_EDITOR_GZIP
+// Compresses or decompresses as it goes so a save never holds the whole compressed file in memory
+class GzipFile final : public EditorFile
+{
+public:
+    GzipFile(const std::string& fileName, ReliveAPI::IFileIO::Mode mode)
+    {
+        const bool write = mode == ReliveAPI::IFileIO::Mode::Write || mode == ReliveAPI::IFileIO::Mode::WriteBinary;
+
+        // Most of a path is base64 camera images which barely compress, the fastest level gets nearly all there is
+        // to get from the rest
+        const char* gzMode = write ? "wb1" : "rb";
+#ifdef _WIN32
+        mFileHandle = ::gzopen_w(QString::fromStdString(fileName).toStdWString().c_str(), gzMode);
+#else
+        mFileHandle = ::gzopen(fileName.c_str(), gzMode);
+#endif
+        if (mFileHandle)
+        {
+            ::gzbuffer(mFileHandle, kBufferSize);
+        }
+    }
+
+    ~GzipFile() override
+    {
+        Close();
+    }
+
+    bool Close() override
+    {
+        if (!IsOpen())
+        {
+            return true;
+        }
+
+        // Writes out what's left in the buffer, the end of the deflate stream and the crc trailer
+        const bool ok = ::gzclose(mFileHandle) == Z_OK;
+        mFileHandle = nullptr;
+        return ok;
+    }
+
+    bool IsOpen() const override
+    {
+        return mFileHandle != nullptr;
+    }
+
+    bool Seek(std::size_t absPos) override
+    {
+        return ::gzseek(mFileHandle, static_cast<z_off_t>(absPos), SEEK_SET) != -1;
+    }
+
+    bool Read(u8* buffer, std::size_t len) override
+    {
+        while (len > 0)
+        {
+            const unsigned int chunk = static_cast<unsigned int>(std::min<std::size_t>(len, kBufferSize));
+            if (::gzread(mFileHandle, buffer, chunk) != static_cast<int>(chunk))
+            {
+                return false;
+            }
+            buffer += chunk;
+            len -= chunk;
+        }
+        return true;
+    }
+
+    bool Write(const u8* buffer, std::size_t len) override
+    {
+        while (len > 0)
+        {
+            const unsigned int chunk = static_cast<unsigned int>(std::min<std::size_t>(len, kBufferSize));
+            if (::gzwrite(mFileHandle, buffer, chunk) != static_cast<int>(chunk))
+            {
+                return false;
+            }
+            buffer += chunk;
+            len -= chunk;
+        }
+        return true;
+    }
+
+    bool ReadInto(std::string& str) override
+    {
+        // The uncompressed size isn't stored anywhere reliable so read until the end
+        str.clear();
+        std::vector<char> chunk(kBufferSize);
+        for (;;)
+        {
+            const int read = ::gzread(mFileHandle, chunk.data(), static_cast<unsigned int>(chunk.size()));
+            if (read < 0)
+            {
+                return false;
+            }
+            if (read == 0)
+            {
+                return true;
+            }
+            str.append(chunk.data(), static_cast<std::size_t>(read));
+        }
+    }
+
+    bool PadEOF(u32) override
+    {
+        // Only lvl files are padded and they are never compressed
+        return false;
+    }
+
+private:
+    static constexpr unsigned int kBufferSize = 256 * 1024;
+
+    gzFile mFileHandle = nullptr;
+};
+#endif
+
 class EditorFileIO final : public ReliveAPI::IFileIO
 {
 public:
     std::unique_ptr<ReliveAPI::IFile> Open(const std::string& fileName, ReliveAPI::IFileIO::Mode mode) override
     {
+        return OpenFile(fileName, mode);
+    }
+
+    // For writes that need to check the file closed cleanly
+    std::unique_ptr<EditorFile> OpenFile(const std::string& fileName, ReliveAPI::IFileIO::Mode mode)
+    {
+        if (IsCompressedJsonFileName(fileName))
+        {
+#ifdef QT_EDITOR_GZIP
+            auto ret = std::make_unique<GzipFile>(fileName, mode);
+            if (!ret->IsOpen())
+            {
+                return nullptr;
+            }
+            return ret;
+#else
+            // Built without zlib
+            return nullptr;
+#endif
+        }
+
         auto ret = std::make_unique<File>(fileName, mode);
         if (!ret->IsOpen())
         {
@@ -148,6 +332,30 @@ public:
     }
 };
 
+// Waits for the os to put a file that has been written and closed on the disk, so renaming it over another file
+// can't leave an empty or partial one behind if the machine goes down
+inline bool SyncFileToDisk(const std::string& fileName)
+{
+#ifdef _WIN32
+    const int fd = ::_wopen(QString::fromStdString(fileName).toStdWString().c_str(), _O_WRONLY | _O_BINARY);
+    if (fd == -1)
+    {
+        return false;
+    }
+    const bool ok = ::_commit(fd) == 0;
+    ::_close(fd);
+#else
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    return ok;
+}
+
 // TODO: Add more context to each of these errors
 template<typename ApiCall>
 bool ExecApiCall(ApiCall apiCall, std::function<void(const QString)> onFailure)
@@ -7,9 +7,10 @@
 #include "Model.hpp"
 #include "PropertyTreeWidget.hpp"
 #include "SnapSettings.hpp"
+#include "EditorGraphicsScene.hpp"
 
-ResizeableArrowItem::ResizeableArrowItem(QGraphicsView* pView, CollisionObject* pLine, ISyncPropertiesToTree& propSyncer, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper)
-    : QGraphicsLineItem(pLine->X2(), pLine->Y2(), pLine->X1(), pLine->Y1()), mView(pView), mLine(pLine), mPropSyncer(propSyncer), mSnapSettings(snapSettings), mSnapper(snapper)
+ResizeableArrowItem::ResizeableArrowItem(QGraphicsView* pView, CollisionObject* pLine, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper)
+    : QGraphicsLineItem(pLine->X2(), pLine->Y2(), pLine->X1(), pLine->Y1()), mView(pView), mLine(pLine), mSnapSettings(snapSettings), mSnapper(snapper)
 {
     Init();
     setZValue(2.0);
@@ -113,42 +114,50 @@ void ResizeableArrowItem::mouseReleaseEvent( QGraphicsSceneMouseEvent* aEvent )
     QGraphicsLineItem::mouseReleaseEvent( aEvent );
 }
 
-void ResizeableArrowItem::paint( QPainter* aPainter, const QStyleOptionGraphicsItem* aOption, QWidget* aWidget /*= nullptr*/ )
+static QColor BrushForLineType(const std::string& prop_id)
 {
-    Q_UNUSED( aWidget );
-
-    // Only draw what is required
-    aPainter->setClipRect( aOption->exposedRect );
-    std::string prop_id = PropertyByName("Type",mLine->mProperties)->mEnumValue;
-    
     if(prop_id == "Art")
     {
-        aPainter->setBrush( QColor(100, 100, 100, 255) );
+        return QColor(100, 100, 100, 255);
     }
     else if(prop_id.find("Background") != std::string::npos)
     {
-        aPainter->setBrush( QColor(150, 150, 75, 255) );
+        return QColor(150, 150, 75, 255);
     }
     else if(prop_id == "Bullet Wall")
     {
-        aPainter->setBrush( QColor(255, 70, 70, 255) );
+        return QColor(255, 70, 70, 255);
     }
     else if(prop_id.find("Flying Slig") != std::string::npos)
     {
-        aPainter->setBrush( QColor(30, 200, 15, 255) );
+        return QColor(30, 200, 15, 255);
     }
     else if(prop_id.find("Mine Car") != std::string::npos)
     {
-        aPainter->setBrush( QColor(190, 70, 255, 255) );
+        return QColor(190, 70, 255, 255);
     }
     else if(prop_id == "Track Line")
     {
-        aPainter->setBrush( QColor(0, 215, 215, 255) );
+        return QColor(0, 215, 215, 255);
     }
     else
     {
-        aPainter->setBrush( QColor(255, 255, 100, 255) );
+        return QColor(255, 255, 100, 255);
     }
+}
+
+void ResizeableArrowItem::paint( QPainter* aPainter, const QStyleOptionGraphicsItem* aOption, QWidget* aWidget /*= nullptr*/ )
+{
+    Q_UNUSED( aWidget );
+
+    // Only draw what is required
+    aPainter->setClipRect( aOption->exposedRect );
+    if (mTypeProperty->mEnumValueIndex != mBrushTypeIndex)
+    {
+        mBrushTypeIndex = mTypeProperty->mEnumValueIndex;
+        mBrush = BrushForLineType(mTypeProperty->EnumValue());
+    }
+    aPainter->setBrush( mBrush );
 
     // Change the pen depending on selection
     if ( isSelected() )
@@ -224,11 +233,25 @@ QVariant ResizeableArrowItem::itemChange(GraphicsItemChange aChange, const QVari
     {
         PosOrLineChanged();
     }
+    else if (aChange == ItemSceneChange)
+    {
+        // See ResizeableRectItem::itemChange()
+        if (auto pOldScene = qobject_cast<EditorGraphicsScene*>(scene()))
+        {
+            pOldScene->UnregisterItem(this);
+        }
+        if (auto pNewScene = qobject_cast<EditorGraphicsScene*>(aValue.value<QGraphicsScene*>()))
+        {
+            pNewScene->RegisterItem(this);
+        }
+    }
     return QGraphicsLineItem::itemChange(aChange, aValue);
 }
 
 void ResizeableArrowItem::Init()
 {
+    mTypeProperty = PropertyByName("Type", mLine->mProperties);
+
     setToolTip("Click and drag an edge of the line to resize it, or hold shift and click and drag to move the line");
 
     QPen p( Qt::black, 2, Qt::SolidLine );
@@ -307,12 +330,6 @@ void ResizeableArrowItem::PosOrLineChanged()
 {
     QLineF curLine = line();
 
-    // Sync the model to the graphics item
-    mLine->SetX1(static_cast<int>(curLine.x2()));
-    mLine->SetY1(static_cast<int>(curLine.y2()));
-    mLine->SetX2(static_cast<int>(curLine.x1()));
-    mLine->SetY2(static_cast<int>(curLine.y1()));
-
-    // Update the property tree view
-    mPropSyncer.Sync(this);
+    // Sync the model to the graphics item, as one change for the property tree view rather than one for each end
+    mLine->SetLine(static_cast<int>(curLine.x2()), static_cast<int>(curLine.y2()), static_cast<int>(curLine.x1()), static_cast<int>(curLine.y1()));
 }
\ No newline at end of file
@@ -1,18 +1,18 @@
 #pragma once
 
+#include <QColor>
 #include <QGraphicsLineItem>
 #include <QGraphicsView>
 #include "IGraphicsItem.hpp"
 
 class CollisionObject;
-class ISyncPropertiesToTree;
 class SnapSettings;
 class IPointSnapper;
 
 class ResizeableArrowItem final : public IGraphicsItem, public QGraphicsLineItem
 {
 public:
-    ResizeableArrowItem(QGraphicsView* pView, CollisionObject* pLine, ISyncPropertiesToTree& propSyncer, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper);
+    ResizeableArrowItem(QGraphicsView* pView, CollisionObject* pLine, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper);
     enum { Type = UserType + 2 };
     int type() const override { return Type; }
     QLineF SaveLine() const;
@@ -24,7 +24,12 @@ public:
         SyncToCollisionItem();
     }
 
-    std::vector<UP_ObjectProperty>& GetProperties() override
+    void MarkInternalObjectDirty() override
+    {
+        mLine->MarkDirty();
+    }
+
+    ObjectProperties& GetProperties() override
     {
         return mLine->mProperties;
     }
@@ -59,7 +64,11 @@ private:
     bool m_MouseIsDown = false;
     QGraphicsView* mView = nullptr;
     CollisionObject* mLine = nullptr;
-    ISyncPropertiesToTree& mPropSyncer;
+
+    // The brush is picked from the name of the line's type, only done again when the type changes
+    const ObjectProperty* mTypeProperty = nullptr;
+    int mBrushTypeIndex = -1;
+    QColor mBrush;
 
     SnapSettings& mSnapSettings;
     IPointSnapper& mSnapper;
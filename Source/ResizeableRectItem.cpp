@@ -13,12 +13,14 @@
 #include "Model.hpp"
 #include "PropertyTreeWidget.hpp"
 #include "SnapSettings.hpp"
+#include "EditorGraphicsScene.hpp"
 
 const quint32 ResizeableRectItem::kMinRectSize = 10;
 
-ResizeableRectItem::ResizeableRectItem(QGraphicsView* pView, MapObject* pMapObject, ISyncPropertiesToTree& propSyncer, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper)
-      : mView(pView), mMapObject(pMapObject), mPropSyncer(propSyncer), mSnapSettings(snapSettings), mPointSnapper(snapper)
+ResizeableRectItem::ResizeableRectItem(QGraphicsView* pView, MapObject* pMapObject, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper)
+      : mView(pView), mMapObject(pMapObject), mSnapSettings(snapSettings), mPointSnapper(snapper)
 {
+    InitIcon();
     SyncFromMapObject();
 
     Init();
@@ -203,7 +205,19 @@ QVariant ResizeableRectItem::itemChange( GraphicsItemChange aChange, const QVari
 {
     if ( aChange == ItemPositionHasChanged )
     {
-        PosOrRectChanged();
+        SyncToMapObject();
+    }
+    else if ( aChange == ItemSceneChange )
+    {
+        // Keep the id lookups of the scene it's leaving and the one it's going to up to date
+        if ( auto pOldScene = qobject_cast<EditorGraphicsScene*>( scene() ) )
+        {
+            pOldScene->UnregisterItem( this );
+        }
+        if ( auto pNewScene = qobject_cast<EditorGraphicsScene*>( aValue.value<QGraphicsScene*>() ) )
+        {
+            pNewScene->RegisterItem( this );
+        }
     }
     return QGraphicsItem::itemChange( aChange, aValue );
 }
@@ -370,7 +384,7 @@ void ResizeableRectItem::SetRect(const QRectF& rect)
     setWidth(rect.width());
     setY(rect.y());
     setHeight(rect.height());
-    PosOrRectChanged();
+    SyncToMapObject();
     UpdateIcon();
 }
 
@@ -385,123 +399,149 @@ void ResizeableRectItem::SyncFromMapObject()
 
 void ResizeableRectItem::SyncToMapObject()
 {
-    mMapObject->SetXPos(static_cast<int>(pos().x()));
-    mMapObject->SetYPos(static_cast<int>(pos().y()));
-    mMapObject->SetWidth(mWidth);
-    mMapObject->SetHeight(mHeight);
+    // One change for the model to tell the property tree view about rather than one for each value
+    mMapObject->SetGeometry(static_cast<int>(pos().x()), static_cast<int>(pos().y()), mWidth, mHeight);
     UpdateIcon();
 }
 
-void ResizeableRectItem::PosOrRectChanged()
+void ResizeableRectItem::InitIcon()
 {
-    SyncToMapObject();
+    const QString imagesPath = ":/object_images/rsc/object_images/";
+    const QString objectName = mMapObject->mObjectStructureType.c_str();
 
-    // Update the property tree view
-    mPropSyncer.Sync(this);
-}
+    mIconKind = IconKind::Fixed;
+    mIconName = imagesPath + objectName;
 
-void ResizeableRectItem::UpdateIcon()
-{
-    QString images_path = ":/object_images/rsc/object_images/";
-    QString object_name = mMapObject->mObjectStructureType.c_str();
-    
-    if( object_name == "BirdPortal" )
+    // The image for each value of the enum that picks it, so only the value index has to be looked at after this
+    auto nameEachValue = [this](const char* propertyName, auto nameOf)
     {
-        if( PropertyByName( "Portal Type", mMapObject->mProperties ))
+        mIconKind = IconKind::ByValue;
+        mIconProperty = PropertyByName(propertyName, mMapObject->mProperties);
+        if (!mIconProperty || mIconProperty->GetType() != ObjectProperty::Type::Enumeration)
         {
-            if(PropertyByName("Portal Type",mMapObject->mProperties)->mEnumValue == "Abe")
-            {
-                object_name += "Abe";
-            }
-            else if(PropertyByName("Portal Type",mMapObject->mProperties)->mEnumValue == "Shrykull")
-            {
-                object_name += "Shrykull";
-            }
+            mIconProperty = nullptr;
+            return;
         }
-    }
-    else if( object_name == "Drill" )
-    {
-        images_path = images_path + object_name + "/";
-        object_name += "_";
-        
-        if( mWidth > 25 )
+
+        for (const std::string& value : mIconProperty->GetEnum().mValues)
         {
-            object_name += QString::number(std::min( mWidth / 25, 9)) + "_1";
+            mIconNames.push_back(nameOf(value));
         }
-        else
+    };
+
+    if (objectName == "BirdPortal")
+    {
+        nameEachValue("Portal Type", [&](const std::string& value)
         {
-            object_name += "1_" + QString::number(std::min( mHeight / 20, 9));
-        }
+            return value == "Abe" || value == "Shrykull" ? mIconName + value.c_str() : mIconName;
+        });
+    }
+    else if (objectName == "Drill")
+    {
+        mIconKind = IconKind::Drill;
+        mIconName = imagesPath + objectName + "/" + objectName + "_";
     }
-    else if( object_name == "Edge" || object_name == "Hoist" )
+    else if (objectName == "Edge" || objectName == "Hoist")
     {
-        images_path = images_path + object_name + "/";
-        
-        if( PropertyByName( "Grab Direction", mMapObject->mProperties ))
+        mIconName = imagesPath + objectName + "/" + objectName;
+        nameEachValue("Grab Direction", [&](const std::string& value)
         {
-            if( PropertyByName( "Grab Direction", mMapObject->mProperties )->mEnumValue == "Facing Right" )
-            {
-                object_name = "Right";
-            }
-            else
-            {
-                object_name = "Left";
-            }
+            return imagesPath + objectName + (value == "Facing Right" ? "/Right" : "/Left");
+        });
+    }
+    else if (objectName == "MotionDetector")
+    {
+        mIconKind = IconKind::MotionDetector;
+        mIconName = imagesPath + objectName + "/";
+    }
+    else if (objectName == "Mudokon")
+    {
+        nameEachValue("Emotion", [&](const std::string& value)
+        {
+            const bool hasImage = value == "Angry" || value == "Sad" || value == "Sick" || value == "Wired";
+            return imagesPath + objectName + "/Mud" + (hasImage ? value.c_str() : "Normal");
+        });
+
+        const ObjectProperty* pBlind = PropertyByName("Blind", mMapObject->mProperties);
+        if (mIconProperty && pBlind && pBlind->GetType() == ObjectProperty::Type::Enumeration)
+        {
+            mBlindProperty = pBlind;
+            mBlindYesIndex = pBlind->GetEnum().IndexOf("Yes");
         }
     }
-    else if( object_name == "MotionDetector" )
+    else if (objectName == "UXB")
     {
-        images_path = images_path + object_name + "/";
-        object_name = QString::number(std::max(std::min((mWidth / 26), 10), 0));
+        nameEachValue("Start State", [&](const std::string& value)
+        {
+            return value == "Off" ? mIconName + "disarmed" : mIconName;
+        });
     }
-    else if( object_name == "Mudokon" )
+}
+
+void ResizeableRectItem::UpdateIcon()
+{
+    // Runs on every step of a resize, so the image is only looked up again when what picks it has changed
+    int variant = 0;
+    switch (mIconKind)
     {
-        if( PropertyByName( "Emotion", mMapObject->mProperties ))
+    case IconKind::Fixed:
+        break;
+
+    case IconKind::ByValue:
+        variant = mIconProperty ? mIconProperty->mEnumValueIndex : -1;
+        if (mBlindProperty && mBlindProperty->mEnumValueIndex == mBlindYesIndex)
         {
-            images_path = images_path + object_name + "/";
-            object_name = "Mud";
-            
-            if( PropertyByName( "Emotion", mMapObject->mProperties )->mEnumValue == "Angry" )
-            {
-                object_name += "Angry";
-            }
-            else if( PropertyByName( "Emotion", mMapObject->mProperties )->mEnumValue == "Sad" )
-            {
-                object_name += "Sad";
-            }
-            else if( PropertyByName( "Emotion", mMapObject->mProperties )->mEnumValue == "Sick" )
-            {
-                object_name += "Sick";
-            }
-            else if( PropertyByName( "Emotion", mMapObject->mProperties )->mEnumValue == "Wired" )
-            {
-                object_name += "Wired";
-            }
-            else
-            {
-                object_name += "Normal";
-            }
-            
-            if(PropertyByName("Blind",mMapObject->mProperties)->mEnumValue == "Yes")
-            {
-                object_name += "B";
-            }
+            variant += static_cast<int>(mIconNames.size());
         }
+        break;
+
+    case IconKind::Drill:
+        // Wide ones are 1 to 9, tall ones -1 to -10
+        variant = mWidth > 25 ? std::min(mWidth / 25, 9) : -std::max(std::min(mHeight / 20, 9), 0) - 1;
+        break;
+
+    case IconKind::MotionDetector:
+        variant = std::max(std::min((mWidth / 26), 10), 0);
+        break;
     }
-    else if( object_name == "UXB" )
+
+    if (mHasIcon && variant == mIconVariant)
+    {
+        return;
+    }
+    mHasIcon = true;
+    mIconVariant = variant;
+
+    QString fileName = mIconName;
+    switch (mIconKind)
     {
-        if( PropertyByName( "Start State", mMapObject->mProperties ))
+    case IconKind::Fixed:
+        break;
+
+    case IconKind::ByValue:
+        if (mIconProperty && mIconProperty->mEnumValueIndex >= 0 && mIconProperty->mEnumValueIndex < static_cast<int>(mIconNames.size()))
         {
-            if(PropertyByName("Start State",mMapObject->mProperties)->mEnumValue == "Off")
+            fileName = mIconNames[mIconProperty->mEnumValueIndex];
+            if (variant >= static_cast<int>(mIconNames.size()))
             {
-                object_name += "disarmed";
+                fileName += "B";
             }
         }
+        break;
+
+    case IconKind::Drill:
+        fileName += variant > 0 ? QString::number(variant) + "_1" : "1_" + QString::number(-variant - 1);
+        break;
+
+    case IconKind::MotionDetector:
+        fileName += QString::number(variant);
+        break;
     }
-    
-    if ( !QPixmapCache::find(images_path + object_name + ".png", &m_Pixmap ) )
+    fileName += ".png";
+
+    if ( !QPixmapCache::find(fileName, &m_Pixmap ) )
     {
-        m_Pixmap = QPixmap(images_path + object_name + ".png");
-        QPixmapCache::insert(images_path + object_name + ".png", m_Pixmap );
+        m_Pixmap = QPixmap(fileName);
+        QPixmapCache::insert(fileName, m_Pixmap );
     }
 }
\ No newline at end of file
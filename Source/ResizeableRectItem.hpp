@@ -2,17 +2,17 @@
 
 #include <QGraphicsRectItem>
 #include <QGraphicsView>
+#include <vector>
 #include "IGraphicsItem.hpp"
 
 struct MapObject;
-class ISyncPropertiesToTree;
 class SnapSettings;
 class IPointSnapper;
 
 class ResizeableRectItem final : public IGraphicsItem, public QGraphicsItem
 {
 public:
-    ResizeableRectItem(QGraphicsView* pView, MapObject* pMapObject, ISyncPropertiesToTree& propSyncer, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper);
+    ResizeableRectItem(QGraphicsView* pView, MapObject* pMapObject, int transparency, SnapSettings& snapSettings, IPointSnapper& snapper);
     enum { Type = UserType + 1 };
     int type() const override { return Type; }
     QRectF CurrentRect() const;
@@ -24,7 +24,12 @@ public:
         SyncFromMapObject();
     }
 
-    std::vector<UP_ObjectProperty>& GetProperties() override
+    void MarkInternalObjectDirty() override
+    {
+        mMapObject->MarkDirty();
+    }
+
+    ObjectProperties& GetProperties() override
     {
         return mMapObject->mProperties;
     }
@@ -52,6 +57,7 @@ private:
         eResize_Bottom
     };
     void Init();
+    void InitIcon();
     void UpdateIcon();
     eResize getResizeLocation( QPointF aPos, QRectF aRect );
     bool IsNear( qreal xP1, qreal xP2 );
@@ -59,7 +65,6 @@ private:
     void SetViewCursor(Qt::CursorShape cursor);
     qreal CalcZPos() const;
     void SyncFromMapObject();
-    void PosOrRectChanged();
     
     void setWidth(int width)
     {
@@ -87,10 +92,31 @@ private:
     QPixmap m_Pixmap;
     QGraphicsView* mView = nullptr;
     MapObject* mMapObject = nullptr;
-    ISyncPropertiesToTree& mPropSyncer;
     int mWidth = 0;
     int mHeight = 0;
 
+    // How the image is picked is worked out from the object's structure once, as its properties never change.
+    // mIconName is the image without the .png when nothing more specific is picked.
+    enum class IconKind
+    {
+        Fixed,
+        ByValue,
+        Drill,
+        MotionDetector,
+    };
+    IconKind mIconKind = IconKind::Fixed;
+    QString mIconName;
+
+    // ByValue, the image for each value index of the property, with a B on the end if the blind property is Yes
+    const ObjectProperty* mIconProperty = nullptr;
+    std::vector<QString> mIconNames;
+    const ObjectProperty* mBlindProperty = nullptr;
+    int mBlindYesIndex = -1;
+
+    // What the current image was picked from
+    bool mHasIcon = false;
+    int mIconVariant = 0;
+
     SnapSettings& mSnapSettings;
     IPointSnapper& mPointSnapper;
 };
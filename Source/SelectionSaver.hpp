@@ -22,16 +22,12 @@ public:
             item->setSelected(true);
         }
 
-        // Redraw
-        mTab->GetScene().update();
-
         // Ensure the property editor is displaying the correct item
         mTab->SyncPropertyEditor();
     }
 
     void redo()
     {
-        mTab->GetScene().update();
         mTab->SyncPropertyEditor();
     }
 
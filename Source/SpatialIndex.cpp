@@ -0,0 +1,649 @@
+#include "SpatialIndex.hpp"
+#include "Model.hpp"
+#include <algorithm>
+#include <type_traits>
+
+// About a third of a camera, small enough that a query near a point only looks at a handful of objects and big
+// enough that most objects are in one or two cells
+constexpr int kCellSize = 128;
+
+// Anything that covers more cells than this, such as a line across the whole map, goes in one list that every query
+// looks at instead of in each of its cells
+constexpr int64_t kMaxCellsPerItem = 256;
+
+static int CellOf(int pos)
+{
+    // Rounds down for negative positions too
+    return pos >= 0 ? pos / kCellSize : -((-static_cast<int64_t>(pos) + kCellSize - 1) / kCellSize);
+}
+
+static std::optional<SpatialRect> BoundsOf(const MapObject& mapObject)
+{
+    const ObjectStructure* pStructure = mapObject.mStructure.get();
+    if (!pStructure ||
+        pStructure->IndexOf(WellKnownProperty::XPos) == -1 ||
+        pStructure->IndexOf(WellKnownProperty::YPos) == -1 ||
+        pStructure->IndexOf(WellKnownProperty::Width) == -1 ||
+        pStructure->IndexOf(WellKnownProperty::Height) == -1)
+    {
+        return {};
+    }
+    return SpatialRect{ mapObject.XPos(), mapObject.YPos(), mapObject.Width(), mapObject.Height() };
+}
+
+static std::optional<SpatialRect> BoundsOf(const CollisionObject& collision)
+{
+    const ObjectStructure* pStructure = collision.mStructure.get();
+    if (!pStructure ||
+        pStructure->IndexOf(WellKnownProperty::X1) == -1 ||
+        pStructure->IndexOf(WellKnownProperty::Y1) == -1 ||
+        pStructure->IndexOf(WellKnownProperty::X2) == -1 ||
+        pStructure->IndexOf(WellKnownProperty::Y2) == -1)
+    {
+        return {};
+    }
+    const int x = std::min(collision.X1(), collision.X2());
+    const int y = std::min(collision.Y1(), collision.Y2());
+    return SpatialRect{ x, y, std::max(collision.X1(), collision.X2()) - x, std::max(collision.Y1(), collision.Y2()) - y };
+}
+
+static bool Overlaps(int64_t aPos, int64_t aSize, int64_t bPos, int64_t bSize)
+{
+    // Objects can have a negative width or height while they are being resized
+    return std::min(aPos, aPos + aSize) <= std::max(bPos, bPos + bSize) && std::min(bPos, bPos + bSize) <= std::max(aPos, aPos + aSize);
+}
+
+static bool Overlaps(const SpatialRect& a, const SpatialRect& b)
+{
+    return Overlaps(a.mX, a.mWidth, b.mX, b.mWidth) && Overlaps(a.mY, a.mHeight, b.mY, b.mHeight);
+}
+
+// Liang-Barsky, clips the line to the rectangle and checks anything is left
+static bool LineInRect(const CollisionObject& collision, SpatialRect rect)
+{
+    if (rect.mWidth < 0)
+    {
+        rect.mX += rect.mWidth;
+        rect.mWidth = -rect.mWidth;
+    }
+    if (rect.mHeight < 0)
+    {
+        rect.mY += rect.mHeight;
+        rect.mHeight = -rect.mHeight;
+    }
+
+    const double x1 = collision.X1();
+    const double y1 = collision.Y1();
+    const double dx = static_cast<double>(collision.X2()) - x1;
+    const double dy = static_cast<double>(collision.Y2()) - y1;
+
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] =
+    {
+        x1 - rect.mX,
+        static_cast<double>(rect.mX) + rect.mWidth - x1,
+        y1 - rect.mY,
+        static_cast<double>(rect.mY) + rect.mHeight - y1
+    };
+
+    double t0 = 0.0;
+    double t1 = 1.0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0.0)
+        {
+            // Parallel to this edge, so either always inside of it or never
+            if (q[i] < 0.0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const double t = q[i] / p[i];
+            if (p[i] < 0.0)
+            {
+                t0 = std::max(t0, t);
+            }
+            else
+            {
+                t1 = std::min(t1, t);
+            }
+            if (t0 > t1)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+SpatialCells SpatialIndex::CellsOf(const SpatialRect& rect)
+{
+    const int64_t x2 = static_cast<int64_t>(rect.mX) + rect.mWidth;
+    const int64_t y2 = static_cast<int64_t>(rect.mY) + rect.mHeight;
+    SpatialCells cells;
+    cells.mMinX = CellOf(static_cast<int>(std::clamp<int64_t>(std::min<int64_t>(rect.mX, x2), INT32_MIN, INT32_MAX)));
+    cells.mMinY = CellOf(static_cast<int>(std::clamp<int64_t>(std::min<int64_t>(rect.mY, y2), INT32_MIN, INT32_MAX)));
+    cells.mMaxX = CellOf(static_cast<int>(std::clamp<int64_t>(std::max<int64_t>(rect.mX, x2), INT32_MIN, INT32_MAX)));
+    cells.mMaxY = CellOf(static_cast<int>(std::clamp<int64_t>(std::max<int64_t>(rect.mY, y2), INT32_MIN, INT32_MAX)));
+    return cells;
+}
+
+uint64_t SpatialIndex::CellKey(int x, int y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+static int64_t CellCount(const SpatialCells& cells)
+{
+    return (static_cast<int64_t>(cells.mMaxX) - cells.mMinX + 1) * (static_cast<int64_t>(cells.mMaxY) - cells.mMinY + 1);
+}
+
+template<typename T>
+void SpatialIndex::Insert(T& item, const SpatialCells& cells)
+{
+    if (cells.mMaxX < cells.mMinX)
+    {
+        return;
+    }
+
+    const Entry<T> entry{ &item, cells.mMinX, cells.mMinY };
+    if (CellCount(cells) > kMaxCellsPerItem)
+    {
+        if constexpr (std::is_same_v<T, MapObject>)
+        {
+            mOversized.mMapObjects.push_back(entry);
+        }
+        else
+        {
+            mOversized.mCollisions.push_back(entry);
+        }
+        return;
+    }
+
+    for (int y = cells.mMinY; y <= cells.mMaxY; y++)
+    {
+        for (int x = cells.mMinX; x <= cells.mMaxX; x++)
+        {
+            Cell& cell = mCells[CellKey(x, y)];
+            if constexpr (std::is_same_v<T, MapObject>)
+            {
+                cell.mMapObjects.push_back(entry);
+            }
+            else
+            {
+                cell.mCollisions.push_back(entry);
+            }
+        }
+    }
+}
+
+template<typename T>
+static void EraseEntry(std::vector<T>& entries, const void* pItem)
+{
+    // Order within a cell doesn't matter
+    for (auto& entry : entries)
+    {
+        if (entry.mItem == pItem)
+        {
+            entry = entries.back();
+            entries.pop_back();
+            return;
+        }
+    }
+}
+
+template<typename T>
+void SpatialIndex::Erase(T& item, const SpatialCells& cells)
+{
+    if (cells.mMaxX < cells.mMinX)
+    {
+        return;
+    }
+
+    if (CellCount(cells) > kMaxCellsPerItem)
+    {
+        if constexpr (std::is_same_v<T, MapObject>)
+        {
+            EraseEntry(mOversized.mMapObjects, &item);
+        }
+        else
+        {
+            EraseEntry(mOversized.mCollisions, &item);
+        }
+        return;
+    }
+
+    for (int y = cells.mMinY; y <= cells.mMaxY; y++)
+    {
+        for (int x = cells.mMinX; x <= cells.mMaxX; x++)
+        {
+            auto it = mCells.find(CellKey(x, y));
+            if (it == mCells.end())
+            {
+                continue;
+            }
+
+            if constexpr (std::is_same_v<T, MapObject>)
+            {
+                EraseEntry(it->second.mMapObjects, &item);
+            }
+            else
+            {
+                EraseEntry(it->second.mCollisions, &item);
+            }
+
+            if (it->second.mMapObjects.empty() && it->second.mCollisions.empty())
+            {
+                mCells.erase(it);
+            }
+        }
+    }
+}
+
+template<typename T, typename Fn>
+void SpatialIndex::ForEachIn(const SpatialRect& rect, Fn fn) const
+{
+    const SpatialCells queryCells = CellsOf(rect);
+
+    // An item in more than one of the cells is only given to fn from the first of them the query covers
+    auto visitCell = [&](int x, int y, const Cell& cell)
+    {
+        const std::vector<Entry<T>>* pEntries = nullptr;
+        if constexpr (std::is_same_v<T, MapObject>)
+        {
+            pEntries = &cell.mMapObjects;
+        }
+        else
+        {
+            pEntries = &cell.mCollisions;
+        }
+
+        for (const Entry<T>& entry : *pEntries)
+        {
+            if (x == std::max(entry.mMinX, queryCells.mMinX) && y == std::max(entry.mMinY, queryCells.mMinY))
+            {
+                fn(*entry.mItem);
+            }
+        }
+    };
+
+    if (CellCount(queryCells) > static_cast<int64_t>(mCells.size()))
+    {
+        // Fewer cells have anything in them than the query covers, such as when selecting the whole map
+        for (const auto& [key, cell] : mCells)
+        {
+            const int x = static_cast<int>(static_cast<uint32_t>(key >> 32));
+            const int y = static_cast<int>(static_cast<uint32_t>(key));
+            if (x >= queryCells.mMinX && x <= queryCells.mMaxX && y >= queryCells.mMinY && y <= queryCells.mMaxY)
+            {
+                visitCell(x, y, cell);
+            }
+        }
+    }
+    else
+    {
+        for (int y = queryCells.mMinY; y <= queryCells.mMaxY; y++)
+        {
+            for (int x = queryCells.mMinX; x <= queryCells.mMaxX; x++)
+            {
+                const auto it = mCells.find(CellKey(x, y));
+                if (it != mCells.end())
+                {
+                    visitCell(x, y, it->second);
+                }
+            }
+        }
+    }
+
+    if constexpr (std::is_same_v<T, MapObject>)
+    {
+        for (const Entry<T>& entry : mOversized.mMapObjects)
+        {
+            fn(*entry.mItem);
+        }
+    }
+    else
+    {
+        for (const Entry<T>& entry : mOversized.mCollisions)
+        {
+            fn(*entry.mItem);
+        }
+    }
+}
+
+void SpatialIndex::AddMapObject(MapObject& mapObject)
+{
+    const std::optional<SpatialRect> bounds = BoundsOf(mapObject);
+    mapObject.mSpatialCells = bounds ? CellsOf(*bounds) : SpatialCells{};
+    Insert(mapObject, mapObject.mSpatialCells);
+}
+
+void SpatialIndex::RemoveMapObject(MapObject& mapObject)
+{
+    Erase(mapObject, mapObject.mSpatialCells);
+    mapObject.mSpatialCells = {};
+}
+
+void SpatialIndex::UpdateMapObject(MapObject& mapObject)
+{
+    const std::optional<SpatialRect> bounds = BoundsOf(mapObject);
+    const SpatialCells cells = bounds ? CellsOf(*bounds) : SpatialCells{};
+    if (cells != mapObject.mSpatialCells)
+    {
+        Erase(mapObject, mapObject.mSpatialCells);
+        mapObject.mSpatialCells = cells;
+        Insert(mapObject, cells);
+    }
+}
+
+void SpatialIndex::AddCollision(CollisionObject& collision)
+{
+    const std::optional<SpatialRect> bounds = BoundsOf(collision);
+    collision.mSpatialCells = bounds ? CellsOf(*bounds) : SpatialCells{};
+    Insert(collision, collision.mSpatialCells);
+}
+
+void SpatialIndex::RemoveCollision(CollisionObject& collision)
+{
+    Erase(collision, collision.mSpatialCells);
+    collision.mSpatialCells = {};
+}
+
+void SpatialIndex::UpdateCollision(CollisionObject& collision)
+{
+    const std::optional<SpatialRect> bounds = BoundsOf(collision);
+    const SpatialCells cells = bounds ? CellsOf(*bounds) : SpatialCells{};
+    if (cells != collision.mSpatialCells)
+    {
+        Erase(collision, collision.mSpatialCells);
+        collision.mSpatialCells = cells;
+        Insert(collision, cells);
+    }
+}
+
+void SpatialIndex::ClearMapObjects()
+{
+    mOversized.mMapObjects.clear();
+    for (auto it = mCells.begin(); it != mCells.end(); )
+    {
+        it->second.mMapObjects.clear();
+        it = it->second.mCollisions.empty() ? mCells.erase(it) : std::next(it);
+    }
+}
+
+void SpatialIndex::ClearCollisions()
+{
+    mOversized.mCollisions.clear();
+    for (auto it = mCells.begin(); it != mCells.end(); )
+    {
+        it->second.mCollisions.clear();
+        it = it->second.mMapObjects.empty() ? mCells.erase(it) : std::next(it);
+    }
+}
+
+std::vector<MapObject*> SpatialIndex::MapObjectsIn(const SpatialRect& rect) const
+{
+    std::vector<MapObject*> found;
+    ForEachIn<MapObject>(rect, [&](MapObject& mapObject)
+    {
+        if (Overlaps(*BoundsOf(mapObject), rect))
+        {
+            found.push_back(&mapObject);
+        }
+    });
+    return found;
+}
+
+std::vector<CollisionObject*> SpatialIndex::CollisionsIn(const SpatialRect& rect) const
+{
+    std::vector<CollisionObject*> found;
+    ForEachIn<CollisionObject>(rect, [&](CollisionObject& collision)
+    {
+        if (LineInRect(collision, rect))
+        {
+            found.push_back(&collision);
+        }
+    });
+    return found;
+}
+
+std::optional<SpatialIndex::NearestEndpoint> SpatialIndex::NearestCollisionEndpoint(int x, int y, int maxDistance, const CollisionObject* pIgnore) const
+{
+    const int64_t maxDistanceSquared = static_cast<int64_t>(maxDistance) * maxDistance;
+    std::optional<NearestEndpoint> nearest;
+
+    auto consider = [&](CollisionObject& collision, bool secondPoint, int pointX, int pointY)
+    {
+        const int64_t dx = static_cast<int64_t>(pointX) - x;
+        const int64_t dy = static_cast<int64_t>(pointY) - y;
+        const int64_t distanceSquared = (dx * dx) + (dy * dy);
+        if (distanceSquared > maxDistanceSquared)
+        {
+            return;
+        }
+
+        // Cells are visited in no particular order so ties go to the oldest line to always give the same answer
+        if (!nearest || distanceSquared < nearest->mDistanceSquared ||
+            (distanceSquared == nearest->mDistanceSquared && collision.mId < nearest->mCollision->mId))
+        {
+            nearest = NearestEndpoint{ &collision, secondPoint, pointX, pointY, distanceSquared };
+        }
+    };
+
+    const SpatialRect searchRect{ x - maxDistance, y - maxDistance, maxDistance * 2, maxDistance * 2 };
+    ForEachIn<CollisionObject>(searchRect, [&](CollisionObject& collision)
+    {
+        if (&collision != pIgnore)
+        {
+            consider(collision, false, collision.X1(), collision.Y1());
+            consider(collision, true, collision.X2(), collision.Y2());
+        }
+    });
+    return nearest;
+}
+
+static std::shared_ptr<ObjectStructure> MakeTestStructure(std::initializer_list<WellKnownProperty> properties)
+{
+    auto structure = std::make_shared<ObjectStructure>();
+    structure->mWellKnownIndices.fill(-1);
+    for (WellKnownProperty property : properties)
+    {
+        structure->mWellKnownIndices[static_cast<size_t>(property)] = static_cast<int>(structure->mEnumAndBasicTypeProperties.size());
+        structure->mEnumAndBasicTypeProperties.emplace_back().mKind = EnumOrBasicTypeProperty::Type::BasicType;
+    }
+    return structure;
+}
+
+template<typename T>
+static void GiveTestProperties(T& item, const std::shared_ptr<ObjectStructure>& structure)
+{
+    item.mStructure = structure;
+    for (const EnumOrBasicTypeProperty& property : structure->mEnumAndBasicTypeProperties)
+    {
+        item.mProperties.emplace_back(property);
+    }
+}
+
+static std::unique_ptr<MapObject> MakeTestMapObject(const std::shared_ptr<ObjectStructure>& structure, int x, int y, int w, int h)
+{
+    auto mapObject = std::make_unique<MapObject>();
+    GiveTestProperties(*mapObject, structure);
+    mapObject->SetGeometry(x, y, w, h);
+    return mapObject;
+}
+
+static std::unique_ptr<CollisionObject> MakeTestCollision(const std::shared_ptr<ObjectStructure>& structure, int id, int x1, int y1, int x2, int y2)
+{
+    auto collision = std::make_unique<CollisionObject>(id);
+    GiveTestProperties(*collision, structure);
+    collision->SetLine(x1, y1, x2, y2);
+    return collision;
+}
+
+template<typename T>
+static bool FoundOnce(const std::vector<T*>& found, const T* pItem)
+{
+    return std::count(found.begin(), found.end(), pItem) == 1;
+}
+
+void Test_MapObjectInManyCells()
+{
+    const auto structure = MakeTestStructure({ WellKnownProperty::XPos, WellKnownProperty::YPos, WellKnownProperty::Width, WellKnownProperty::Height });
+    SpatialIndex index;
+    auto mapObject = MakeTestMapObject(structure, 100, 100, 300, 300);
+    index.AddMapObject(*mapObject);
+
+    // Found from a cell it only partly covers, not from outside of it and only once when the query covers all of it
+    if (!FoundOnce(index.MapObjectsIn({ 350, 350, 1, 1 }), mapObject.get()) ||
+        !index.MapObjectsIn({ 0, 0, 50, 50 }).empty() ||
+        !FoundOnce(index.MapObjectsIn({ -1000, -1000, 3000, 3000 }), mapObject.get()))
+    {
+        abort();
+    }
+
+    mapObject->SetGeometry(1000, 1000, 10, 10);
+    index.UpdateMapObject(*mapObject);
+    if (!index.MapObjectsIn({ 350, 350, 1, 1 }).empty() || !FoundOnce(index.MapObjectsIn({ 1005, 1005, 0, 0 }), mapObject.get()))
+    {
+        abort();
+    }
+
+    index.RemoveMapObject(*mapObject);
+    if (!index.MapObjectsIn({ -1000, -1000, 3000, 3000 }).empty())
+    {
+        abort();
+    }
+}
+
+void Test_OversizedMapObject()
+{
+    const auto structure = MakeTestStructure({ WellKnownProperty::XPos, WellKnownProperty::YPos, WellKnownProperty::Width, WellKnownProperty::Height });
+    SpatialIndex index;
+    auto oversized = MakeTestMapObject(structure, 0, 0, kCellSize * 40, kCellSize * 40);
+    auto small = MakeTestMapObject(structure, 10, 10, 5, 5);
+    index.AddMapObject(*oversized);
+    index.AddMapObject(*small);
+
+    const std::vector<MapObject*> found = index.MapObjectsIn({ 0, 0, kCellSize * 40, kCellSize * 40 });
+    if (found.size() != 2 || !FoundOnce(found, oversized.get()) || !FoundOnce(found, small.get()) ||
+        !FoundOnce(index.MapObjectsIn({ kCellSize * 20, kCellSize * 20, 0, 0 }), oversized.get()) ||
+        !index.MapObjectsIn({ kCellSize * 50, kCellSize * 50, 10, 10 }).empty())
+    {
+        abort();
+    }
+
+    // Shrinking it moves it from the oversized list into cells
+    oversized->SetGeometry(kCellSize * 30, kCellSize * 30, 10, 10);
+    index.UpdateMapObject(*oversized);
+    if (!index.MapObjectsIn({ kCellSize * 20, kCellSize * 20, 0, 0 }).empty() ||
+        !FoundOnce(index.MapObjectsIn({ kCellSize * 30, kCellSize * 30, 0, 0 }), oversized.get()))
+    {
+        abort();
+    }
+}
+
+void Test_NegativePositions()
+{
+    const auto structure = MakeTestStructure({ WellKnownProperty::XPos, WellKnownProperty::YPos, WellKnownProperty::Width, WellKnownProperty::Height });
+    SpatialIndex index;
+    auto negative = MakeTestMapObject(structure, -300, -50, 10, 10);
+    auto acrossZero = MakeTestMapObject(structure, -5, -5, 10, 10);
+    index.AddMapObject(*negative);
+    index.AddMapObject(*acrossZero);
+
+    if (!FoundOnce(index.MapObjectsIn({ -295, -45, 0, 0 }), negative.get()) ||
+        !FoundOnce(index.MapObjectsIn({ -3, -3, 0, 0 }), acrossZero.get()) ||
+        !FoundOnce(index.MapObjectsIn({ 3, 3, 0, 0 }), acrossZero.get()) ||
+        !FoundOnce(index.MapObjectsIn({ -10, -10, 20, 20 }), acrossZero.get()) ||
+        FoundOnce(index.MapObjectsIn({ -10, -10, 20, 20 }), negative.get()))
+    {
+        abort();
+    }
+
+    // A query rectangle can be given from its far corner too
+    if (!FoundOnce(index.MapObjectsIn({ -280, -30, -20, -20 }), negative.get()))
+    {
+        abort();
+    }
+}
+
+void Test_CollisionsIn()
+{
+    const auto structure = MakeTestStructure({ WellKnownProperty::X1, WellKnownProperty::Y1, WellKnownProperty::X2, WellKnownProperty::Y2 });
+    SpatialIndex index;
+    auto horizontal = MakeTestCollision(structure, 1, -500, 0, 1000, 0);
+    auto diagonal = MakeTestCollision(structure, 2, 0, 0, 1000, 1000);
+    index.AddCollision(*horizontal);
+    index.AddCollision(*diagonal);
+
+    // The horizontal line is in a dozen cells but only found once
+    std::vector<CollisionObject*> found = index.CollisionsIn({ -1000, -10, 3000, 20 });
+    if (!FoundOnce(found, horizontal.get()) || !FoundOnce(found, diagonal.get()) || found.size() != 2)
+    {
+        abort();
+    }
+
+    // Inside the diagonal's bounding box but nowhere near the line itself
+    if (!index.CollisionsIn({ 900, 100, 50, 50 }).empty())
+    {
+        abort();
+    }
+
+    index.RemoveCollision(*horizontal);
+    found = index.CollisionsIn({ -1000, -10, 3000, 20 });
+    if (found.size() != 1 || found[0] != diagonal.get())
+    {
+        abort();
+    }
+}
+
+void Test_NearestCollisionEndpoint()
+{
+    const auto structure = MakeTestStructure({ WellKnownProperty::X1, WellKnownProperty::Y1, WellKnownProperty::X2, WellKnownProperty::Y2 });
+    SpatialIndex index;
+    auto newer = MakeTestCollision(structure, 7, 10, 0, 500, 0);
+    auto older = MakeTestCollision(structure, 3, -500, 0, -10, 0);
+    auto closest = MakeTestCollision(structure, 9, 0, 300, 0, 5000);
+    index.AddCollision(*newer);
+    index.AddCollision(*older);
+    index.AddCollision(*closest);
+
+    // Both are 10 away so the one with the lower id wins whichever order the cells are visited in
+    std::optional<SpatialIndex::NearestEndpoint> nearest = index.NearestCollisionEndpoint(0, 0, 20);
+    if (!nearest || nearest->mCollision != older.get() || !nearest->mSecondPoint || nearest->mX != -10 || nearest->mDistanceSquared != 100)
+    {
+        abort();
+    }
+
+    nearest = index.NearestCollisionEndpoint(0, 0, 20, older.get());
+    if (!nearest || nearest->mCollision != newer.get() || nearest->mSecondPoint)
+    {
+        abort();
+    }
+
+    // Nearer than either of them, and nothing in range
+    nearest = index.NearestCollisionEndpoint(0, 295, 20);
+    if (!nearest || nearest->mCollision != closest.get() || nearest->mY != 300 ||
+        index.NearestCollisionEndpoint(0, 150, 20))
+    {
+        abort();
+    }
+
+    // The far end of a line across many cells
+    nearest = index.NearestCollisionEndpoint(3, 4998, 20);
+    if (!nearest || nearest->mCollision != closest.get() || !nearest->mSecondPoint)
+    {
+        abort();
+    }
+}
+
+void DoSpatialIndexTests()
+{
+    Test_MapObjectInManyCells();
+    Test_OversizedMapObject();
+    Test_NegativePositions();
+    Test_CollisionsIn();
+    Test_NearestCollisionEndpoint();
+}
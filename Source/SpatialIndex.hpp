@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+struct MapObject;
+class CollisionObject;
+
+// A rectangle in map coordinates, the edges are included so a rectangle with no width or height is a point
+struct SpatialRect final
+{
+    int mX = 0;
+    int mY = 0;
+    int mWidth = 0;
+    int mHeight = 0;
+};
+
+// The cells of a SpatialIndex an object or line is in, kept by the object so it can tell when it moved to other ones
+struct SpatialCells final
+{
+    int mMinX = 0;
+    int mMinY = 0;
+    int mMaxX = -1;
+    int mMaxY = -1;
+
+    bool operator==(const SpatialCells& rhs) const
+    {
+        return mMinX == rhs.mMinX && mMinY == rhs.mMinY && mMaxX == rhs.mMaxX && mMaxY == rhs.mMaxY;
+    }
+
+    bool operator!=(const SpatialCells& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+// Where the map objects and collision lines of a model are, bucketed in a uniform grid of cells so finding what is
+// near a point or in a rectangle only looks at the cells it covers. The model keeps it up to date as objects and
+// lines are added, removed and moved (anything that moves one calls its MarkDirty() which updates the cells it is in)
+// so it can be queried at any time, including without a scene such as from the command line.
+class SpatialIndex final
+{
+public:
+    struct NearestEndpoint final
+    {
+        CollisionObject* mCollision = nullptr;
+
+        // False for X1,Y1 and true for X2,Y2
+        bool mSecondPoint = false;
+
+        int mX = 0;
+        int mY = 0;
+        int64_t mDistanceSquared = 0;
+    };
+
+    void AddMapObject(MapObject& mapObject);
+    void RemoveMapObject(MapObject& mapObject);
+    void UpdateMapObject(MapObject& mapObject);
+
+    void AddCollision(CollisionObject& collision);
+    void RemoveCollision(CollisionObject& collision);
+    void UpdateCollision(CollisionObject& collision);
+
+    // Forget everything of one kind without touching the objects, for when the model replaces all of them
+    void ClearMapObjects();
+    void ClearCollisions();
+
+    // Objects whose rectangle overlaps rect, each appears once
+    std::vector<MapObject*> MapObjectsIn(const SpatialRect& rect) const;
+
+    // Lines that cross or are inside rect, each appears once
+    std::vector<CollisionObject*> CollisionsIn(const SpatialRect& rect) const;
+
+    // The end of a line closest to x, y that is no further than maxDistance from it
+    std::optional<NearestEndpoint> NearestCollisionEndpoint(int x, int y, int maxDistance, const CollisionObject* pIgnore = nullptr) const;
+
+private:
+    template<typename T>
+    struct Entry final
+    {
+        T* mItem = nullptr;
+
+        // Copied from the item's cells so a query can tell which cell it first meets the item in without a lookup
+        int mMinX = 0;
+        int mMinY = 0;
+    };
+
+    struct Cell final
+    {
+        std::vector<Entry<MapObject>> mMapObjects;
+        std::vector<Entry<CollisionObject>> mCollisions;
+    };
+
+    static SpatialCells CellsOf(const SpatialRect& rect);
+    static uint64_t CellKey(int x, int y);
+
+    template<typename T>
+    void Insert(T& item, const SpatialCells& cells);
+
+    template<typename T>
+    void Erase(T& item, const SpatialCells& cells);
+
+    template<typename T, typename Fn>
+    void ForEachIn(const SpatialRect& rect, Fn fn) const;
+
+    std::unordered_map<uint64_t, Cell> mCells;
+
+    // Items that cover too many cells to put in each of them, every query looks through all of these
+    Cell mOversized;
+};
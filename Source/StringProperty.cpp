@@ -1,6 +1,7 @@
 #include "StringProperty.hpp"
 #include <QComboBox>
 #include "Model.hpp"
+#include "IGraphicsItem.hpp"
 
 ReadOnlyStringProperty::ReadOnlyStringProperty(QTreeWidgetItem* pParent, QString propertyName, int* pProperty)
     : PropertyTreeItemBase(pParent, QStringList{ propertyName, QString::number(*pProperty) }), mProperty(pProperty)
@@ -8,8 +9,8 @@ ReadOnlyStringProperty::ReadOnlyStringProperty(QTreeWidgetItem* pParent, QString
 
 }
 
-StringProperty::StringProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, std::string* pProperty) 
-    : PropertyTreeItemBase(pParent, QStringList{ propertyName, pProperty->c_str() }), mUndoStack(undoStack), mProperty(pProperty)
+StringProperty::StringProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, std::string* pProperty, IGraphicsItem* pGraphicsItem) 
+    : PropertyTreeItemBase(pParent, QStringList{ propertyName, pProperty->c_str() }), mProperty(pProperty), mGraphicsItem(pGraphicsItem), mUndoStack(undoStack)
 {
     mPrevValue = mProperty->c_str();
 }
@@ -26,7 +27,7 @@ QWidget* StringProperty::CreateEditorWidget(PropertyTreeWidget* pParent)
             {
                 if (!edit->text().isEmpty())
                 {
-                    mUndoStack.push(new ChangeStringPropertyCommand(pParent, mProperty, text(0), mPrevValue, edit->text()));
+                    mUndoStack.push(new ChangeStringPropertyCommand(mProperty, mGraphicsItem, text(0), mPrevValue, edit->text()));
                     mPrevValue = mProperty->c_str();
                     pParent->setItemWidget(this, 1, nullptr);
                 }
@@ -41,8 +42,8 @@ void StringProperty::Refresh()
     setText(1, mProperty->c_str());
 }
 
-ChangeStringPropertyCommand::ChangeStringPropertyCommand(PropertyTreeWidget* pTreeWidget, std::string* pProperty, QString propertyName, QString oldValue, QString newValue) 
-    : mTreeWidget(pTreeWidget), mProperty(pProperty), mOldValue(oldValue), mNewValue(newValue)
+ChangeStringPropertyCommand::ChangeStringPropertyCommand(std::string* pProperty, IGraphicsItem* pGraphicsItem, QString propertyName, QString oldValue, QString newValue) 
+    : mProperty(pProperty), mGraphicsItem(pGraphicsItem), mOldValue(oldValue), mNewValue(newValue)
 {
     setText(QString("Change property %1 from %2 to %3").arg(propertyName.trimmed(), oldValue, newValue));
 }
@@ -50,11 +51,11 @@ ChangeStringPropertyCommand::ChangeStringPropertyCommand(PropertyTreeWidget* pTr
 void ChangeStringPropertyCommand::undo()
 {
     *mProperty = mOldValue.toStdString();
-    mTreeWidget->FindObjectPropertyByKey(mProperty)->Refresh();
+    mGraphicsItem->MarkInternalObjectDirty();
 }
 
 void ChangeStringPropertyCommand::redo()
 {
     *mProperty = mNewValue.toStdString();
-    mTreeWidget->FindObjectPropertyByKey(mProperty)->Refresh();
+    mGraphicsItem->MarkInternalObjectDirty();
 }
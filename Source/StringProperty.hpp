@@ -6,19 +6,20 @@
 #include "PropertyTreeItemBase.hpp"
 
 class PropertyTreeWidget;
+class IGraphicsItem;
 
 class ChangeStringPropertyCommand : public QUndoCommand
 {
 public:
-    ChangeStringPropertyCommand(PropertyTreeWidget* pTreeWidget, std::string* pProperty, QString propertyName, QString oldValue, QString newValue);
+    ChangeStringPropertyCommand(std::string* pProperty, IGraphicsItem* pGraphicsItem, QString propertyName, QString oldValue, QString newValue);
 
     void undo() override;
 
     void redo() override;
 
 private:
-    PropertyTreeWidget* mTreeWidget = nullptr;
     std::string* mProperty = nullptr;
+    IGraphicsItem* mGraphicsItem = nullptr;
     QString mOldValue;
     QString mNewValue;
 };
@@ -38,11 +39,6 @@ public:
         setText(1, QString::number(*mProperty));
     }
 
-    const void* GetPropertyLookUpKey() const override
-    {
-        return mProperty;
-    }
-
 private:
     int* mProperty = nullptr;
 };
@@ -51,19 +47,15 @@ class StringProperty : public QObject, public PropertyTreeItemBase
 {
     Q_OBJECT
 public:
-    StringProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, std::string* pProperty);
+    StringProperty(QUndoStack& undoStack, QTreeWidgetItem* pParent, QString propertyName, std::string* pProperty, IGraphicsItem* pGraphicsItem);
 
     virtual QWidget* CreateEditorWidget(PropertyTreeWidget* pParent) override;
 
     virtual void Refresh() override;
 
-    const void* GetPropertyLookUpKey() const override
-    {
-        return mProperty;
-    }
-
 private:
     std::string* mProperty = nullptr;
+    IGraphicsItem* mGraphicsItem = nullptr;
     QString mPrevValue;
     QUndoStack& mUndoStack;
 };
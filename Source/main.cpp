@@ -7,8 +7,12 @@
 #include <functional>
 #include <QtCore/qcommandlineparser.h>
 #include "ReliveApiWrapper.hpp"
+#include "ModelSnapshot.hpp"
 
 void DoMapSizeTests();
+void DoSpatialIndexTests();
+void DoJsonTests();
+void DoEditorTabTests();
 
 static int exportJsonToLvlCommandLine(const QStringList& args)
 {
@@ -45,9 +49,45 @@ static int exportJsonToLvlCommandLine(const QStringList& args)
     return runResult;
 }
 
+static int convertJsonCommandLine(const QStringList& args)
+{
+    if (args.size() != 2)
+    {
+        std::cerr << "Incorrect usage of the --convert option, should be --convert source dest" << std::endl;
+        return 1;
+    }
+
+    // Whether each side is compressed comes from its name, .json.gz or .json
+    if (!IsJsonFileNameSupported(args.at(0).toStdString()) || !IsJsonFileNameSupported(args.at(1).toStdString()))
+    {
+        std::cerr << "Converting failed. " << kNoGzipSupportMessage << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        Model model;
+        model.LoadJsonFromFile(args.at(0).toStdString());
+        if (!model.Snapshot()->SaveJsonToFile(args.at(1).toStdString()))
+        {
+            std::cerr << "Converting failed. Couldn't write " << args.at(1).toStdString() << std::endl;
+            return 1;
+        }
+    }
+    catch (const ModelException& e)
+    {
+        std::cerr << "Converting failed. Couldn't load " << args.at(0).toStdString() << " " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     DoMapSizeTests();
+    DoSpatialIndexTests();
+    DoJsonTests();
+    DoEditorTabTests();
 
     QTranslator translator;
 
@@ -64,9 +104,12 @@ int main(int argc, char *argv[])
     parser.addPositionalArgument("source", QCoreApplication::translate("main", "Source file."));
     parser.addPositionalArgument("dest", QCoreApplication::translate("main", "Destination file."));
 
-    QCommandLineOption exportJsonToLvlOption("export", QCoreApplication::translate("main", "Export the .json file to the .lvl file. Usage: --export source dest"));
+    QCommandLineOption exportJsonToLvlOption("export", QCoreApplication::translate("main", "Export the .json or .json.gz file to the .lvl file. Usage: --export source dest"));
     parser.addOption(exportJsonToLvlOption);
 
+    QCommandLineOption convertJsonOption("convert", QCoreApplication::translate("main", "Convert between .json and .json.gz, the file names give the formats. Usage: --convert source dest"));
+    parser.addOption(convertJsonOption);
+
     parser.process(app);
 
     const QStringList args = parser.positionalArguments();
@@ -76,6 +119,11 @@ int main(int argc, char *argv[])
         return exportJsonToLvlCommandLine(args);
     }
 
+    if (parser.isSet(convertJsonOption))
+    {
+        return convertJsonCommandLine(args);
+    }
+
     EditorMainWindow w;
 
     app.setWindowIcon(QIcon(":/icons/rsc/icons/icon.png"));